@@ -0,0 +1,140 @@
+/**
+ * Character classification throughput.
+ *
+ * Classifies every character of the given corpus files (or a generated
+ * Python/shell mix) the way detection does, once with range comparisons and
+ * once through the generated char_classes[] table, and reports millions of
+ * characters classified per second for each. Then times bare subprocess
+ * detection over every line of the same text: that number, not the first two,
+ * decides which form the scanner's hot helpers take.
+ *
+ *   bench/char_class test/corpus/<file>.txt ...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/scanner.c"
+
+#include "corpus.h"
+#include "generate.h"
+
+#include <time.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * The comparisons detection uses.
+ */
+
+static inline bool range_identifier_start(int32_t c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static inline bool range_digit(int32_t c) { return c >= '0' && c <= '9'; }
+
+static inline bool range_whitespace(int32_t c) { return c == ' ' || c == '\t'; }
+
+/**
+ * Sort a character into one of four buckets with range comparisons, in the
+ * order the detection loop asks.
+ */
+static inline unsigned classify_by_range(int32_t c) {
+    if (range_whitespace(c)) {
+        return 0;
+    }
+    if (range_identifier_start(c)) {
+        return 1;
+    }
+    if (range_digit(c)) {
+        return 2;
+    }
+    return 3;
+}
+
+static inline unsigned classify_by_table(int32_t c) {
+    if (c == ' ' || c == '\t') {
+        return 0;
+    }
+    uint8_t classes = char_class(c);
+    if (classes & CHAR_IDENTIFIER_START) {
+        return 1;
+    }
+    // An identifier character that cannot start one is a digit
+    return classes & CHAR_IDENTIFIER ? 2 : 3;
+}
+
+// Keep the compiler from folding the loops away
+static volatile uint64_t sink;
+
+// One loop per classifier, so each is inlined rather than called
+#define RUN_CLASSIFICATION(name, data, length, rounds, classify)                             \
+    do {                                                                                     \
+        uint64_t buckets[4] = {0};                                                           \
+        uint64_t start = now_ns();                                                           \
+        for (unsigned round = 0; round < (rounds); round++) {                                \
+            for (size_t i = 0; i < (length); i++) {                                         \
+                buckets[classify((unsigned char)(data)[i])]++;                               \
+            }                                                                                \
+        }                                                                                    \
+        double seconds = (double)(now_ns() - start) / 1e9;                                   \
+        sink = buckets[0] + buckets[1] + buckets[2] + buckets[3];                            \
+        printf("%-20s %12zu %12.1f\n", name, (size_t)(length),                               \
+               (double)(length) * (rounds) / seconds / 1e6);                                 \
+    } while (0)
+
+/**
+ * Run detection at every line start of `data` that the scanner would, and
+ * report the average time per line.
+ */
+static void run_detection(const char *data, size_t length, unsigned rounds) {
+    uint64_t lines = 0;
+    uint64_t start = now_ns();
+    for (unsigned round = 0; round < rounds; round++) {
+        size_t position = 0;
+        while (position < length) {
+            const char *newline = memchr(&data[position], '\n', length - position);
+            size_t end = newline ? (size_t)(newline - data) : length;
+            BufferLexer lexer = {0};
+            buffer_lexer_reset(&lexer, data, end, position);
+            size_t macro_end;
+            Delimiter delimiter = new_delimiter();
+            sink = detect_subprocess_line(&lexer.lexer, &macro_end, &delimiter);
+            lines++;
+            position = end + 1;
+        }
+    }
+    double ns = (double)(now_ns() - start) / (double)lines;
+    printf("%-20s %12zu %12.1f   (ns per line, %.1f chars/line)\n", "detect", length, ns,
+           (double)length / (double)(lines / rounds));
+}
+
+int main(int argc, char **argv) {
+    TextBuffer text = {0};
+    for (int i = 1; i < argc; i++) {
+        SourceText file;
+        if (!source_text_read(argv[i], &file)) {
+            return 1;
+        }
+        size_t cursor = 0, start, end;
+        while (corpus_next_input(&file, &cursor, &start, &end)) {
+            text_buffer_append(&text, &file.data[start], end - start);
+        }
+        source_text_free(&file);
+    }
+    if (text.length == 0) {
+        generate_input(&text, INPUT_BALANCED_MIX, 256 * 1024);
+    }
+    unsigned rounds = (unsigned)(64 * 1024 * 1024 / text.length) + 1;
+
+    printf("%-20s %12s %12s\n", "classifier", "chars", "Mchars/s");
+    RUN_CLASSIFICATION("range-compare", text.data, text.length, rounds, classify_by_range);
+    RUN_CLASSIFICATION("class-table", text.data, text.length, rounds, classify_by_table);
+    run_detection(text.data, text.length, rounds / 8 + 1);
+
+    text_buffer_free(&text);
+    return 0;
+}
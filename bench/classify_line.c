@@ -0,0 +1,114 @@
+/**
+ * Cost of tree_sitter_xonsh_classify_line, the parse-free line classifier.
+ *
+ * Classifies every line of the given corpus files and of generated Python,
+ * shell and mixed sources, many rounds over, and reports the time per line
+ * and how the lines were classified.
+ *
+ *   bench/classify_line test/corpus/<file>.txt ...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/scanner.c"
+
+#include "corpus.h"
+#include "generate.h"
+
+#include <time.h>
+
+typedef struct {
+    const char *data;
+    size_t length;
+} Line;
+
+typedef struct {
+    Line *lines;
+    size_t count;
+    size_t capacity;
+    size_t bytes;
+} LineSet;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void line_set_add(LineSet *set, const char *data, size_t start, size_t end) {
+    while (start < end) {
+        const char *newline = memchr(&data[start], '\n', end - start);
+        size_t line_end = newline ? (size_t)(newline - data) : end;
+        if (set->count == set->capacity) {
+            set->capacity = set->capacity ? set->capacity * 2 : 1024;
+            set->lines = realloc(set->lines, set->capacity * sizeof(Line));
+        }
+        set->lines[set->count++] = (Line){&data[start], line_end - start};
+        set->bytes += line_end - start;
+        start = line_end + 1;
+    }
+}
+
+/**
+ * Classify every line `rounds` times and print one row.
+ */
+static void run(const char *name, const LineSet *set, unsigned rounds) {
+    if (set->count == 0) {
+        return;
+    }
+    uint64_t kinds[4] = {0};
+    size_t macro_end;
+    for (size_t i = 0; i < set->count; i++) {
+        kinds[tree_sitter_xonsh_classify_line(set->lines[i].data, set->lines[i].length, &macro_end)]++;
+    }
+
+    uint64_t start = now_ns();
+    for (unsigned round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < set->count; i++) {
+            tree_sitter_xonsh_classify_line(set->lines[i].data, set->lines[i].length, &macro_end);
+        }
+    }
+    double ns = (double)(now_ns() - start) / ((double)set->count * rounds);
+
+    printf("%-24s %8zu %10.1f %10.1f %8llu %8llu %8llu %8llu\n", name, set->count,
+           (double)set->bytes / (double)set->count, ns, (unsigned long long)kinds[TREE_SITTER_XONSH_LINE_PYTHON],
+           (unsigned long long)kinds[TREE_SITTER_XONSH_LINE_SUBPROCESS],
+           (unsigned long long)kinds[TREE_SITTER_XONSH_LINE_SUBPROCESS_MACRO],
+           (unsigned long long)kinds[TREE_SITTER_XONSH_LINE_BLOCK_MACRO]);
+}
+
+int main(int argc, char **argv) {
+    printf("%-24s %8s %10s %10s %8s %8s %8s %8s\n", "input", "lines", "bytes/line", "ns/line", "python",
+           "subproc", "macro", "block");
+
+    SourceText *texts = calloc((size_t)argc, sizeof(SourceText));
+    LineSet corpus = {0};
+    for (int i = 1; i < argc; i++) {
+        if (!source_text_read(argv[i], &texts[i])) {
+            return 1;
+        }
+        size_t cursor = 0, start, end;
+        while (corpus_next_input(&texts[i], &cursor, &start, &end)) {
+            line_set_add(&corpus, texts[i].data, start, end);
+        }
+    }
+    run("corpus", &corpus, 2000);
+
+    static const GeneratedInput kinds[] = {INPUT_PYTHON_HEAVY, INPUT_SHELL_HEAVY, INPUT_LONG_PIPELINES};
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        TextBuffer source = {0};
+        generate_input(&source, kinds[k], 256 * 1024);
+        LineSet set = {0};
+        line_set_add(&set, source.data, 0, source.length);
+        run(generated_input_names[kinds[k]], &set, 20);
+        free(set.lines);
+        text_buffer_free(&source);
+    }
+
+    free(corpus.lines);
+    for (int i = 1; i < argc; i++) {
+        source_text_free(&texts[i]);
+    }
+    free(texts);
+    return 0;
+}
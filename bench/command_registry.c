@@ -0,0 +1,83 @@
+/**
+ * Runtime command registry lookup cost.
+ *
+ * Registers growing numbers of synthetic command names and measures the
+ * per-lookup cost of is_command_name for registered names and for misses,
+ * which should stay flat as the registry grows.
+ *
+ *   bench/command_registry
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/scanner.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#define LOOKUPS 4000000
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static size_t make_name(char *buffer, const char *prefix, uint32_t n) {
+    // Mix the index so names do not share long common prefixes
+    uint32_t mixed = n * 2654435761u;
+    return (size_t)snprintf(buffer, 64, "%s%x_%u", prefix, mixed, n);
+}
+
+typedef struct {
+    char text[64];
+    size_t length;
+} Name;
+
+static double measure(const Name *names, uint32_t count, size_t *found) {
+    *found = 0;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < LOOKUPS; i++) {
+        const Name *name = &names[i % count];
+        *found += is_command_name(name->text, name->length);
+    }
+    return (double)(now_ns() - start) / LOOKUPS;
+}
+
+int main(void) {
+    static const uint32_t sizes[] = {100, 1000, 10000, 50000, 100000};
+    uint32_t largest = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    Name *registered = malloc(largest * sizeof(Name));
+    Name *unknown = malloc(largest * sizeof(Name));
+    for (uint32_t i = 0; i < largest; i++) {
+        registered[i].length = make_name(registered[i].text, "cmd", i);
+        unknown[i].length = make_name(unknown[i].text, "nop", i);
+    }
+
+    printf("%10s %10s %12s %12s %14s\n", "names", "slots", "hit_ns", "miss_ns", "bytes_per_name");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        command_registry_clear();
+        for (uint32_t i = 0; i < sizes[s]; i++) {
+            if (!tree_sitter_xonsh_register_command(registered[i].text, registered[i].length)) {
+                fprintf(stderr, "failed to register %s\n", registered[i].text);
+                return 1;
+            }
+        }
+
+        size_t hits, misses;
+        double hit_ns = measure(registered, sizes[s], &hits);
+        double miss_ns = measure(unknown, sizes[s], &misses);
+        if (hits != LOOKUPS || misses != 0) {
+            fprintf(stderr, "lookup mismatch: %zu hits, %zu false hits\n", hits, misses);
+            return 1;
+        }
+        double bytes = (double)command_registry.names.capacity +
+                       (double)command_registry.capacity * sizeof(CommandSlot);
+        printf("%10u %10u %12.2f %12.2f %14.1f\n", sizes[s], command_registry.capacity, hit_ns, miss_ns,
+               bytes / sizes[s]);
+    }
+    command_registry_clear();
+    free(registered);
+    free(unknown);
+    return 0;
+}
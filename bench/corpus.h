@@ -0,0 +1,96 @@
+/**
+ * Helpers for reading benchmark inputs.
+ *
+ * Files under test/corpus/ hold many test cases in tree-sitter's corpus
+ * format; only the source between each header and its `---` separator is
+ * xonsh, so benchmarks walk those sections instead of the raw file.
+ */
+
+#ifndef XONSH_BENCH_CORPUS_H_
+#define XONSH_BENCH_CORPUS_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char *data;
+    size_t length;
+} SourceText;
+
+/**
+ * Read a whole file into memory. Returns false (and prints why) on failure.
+ */
+static inline bool source_text_read(const char *path, SourceText *text) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    text->data = malloc((size_t)size + 1);
+    text->length = fread(text->data, 1, (size_t)size, file);
+    text->data[text->length] = '\0';
+    fclose(file);
+    return true;
+}
+
+static inline void source_text_free(SourceText *text) {
+    free(text->data);
+    text->data = NULL;
+    text->length = 0;
+}
+
+static inline size_t corpus__line_end(const SourceText *text, size_t position) {
+    const char *newline = memchr(&text->data[position], '\n', text->length - position);
+    return newline ? (size_t)(newline - text->data) : text->length;
+}
+
+static inline bool corpus__line_is(const SourceText *text, size_t start, size_t end, char c, size_t min_run) {
+    size_t i = start;
+    while (i < end && text->data[i] == c) {
+        i++;
+    }
+    return i - start >= min_run && (i == end || c == '=');
+}
+
+/**
+ * Find the next test input in a corpus file, starting the search at `*cursor`.
+ * On success stores the input's byte range in `*start`/`*end` and moves the
+ * cursor past it.
+ */
+static inline bool corpus_next_input(const SourceText *text, size_t *cursor, size_t *start, size_t *end) {
+    size_t position = *cursor;
+    int header_lines = 0;
+    while (position < text->length) {
+        size_t line_end = corpus__line_end(text, position);
+        if (corpus__line_is(text, position, line_end, '=', 3)) {
+            header_lines++;
+            if (header_lines == 2) {
+                position = line_end + 1;
+                break;
+            }
+        }
+        position = line_end + 1;
+    }
+    if (header_lines < 2 || position >= text->length) {
+        return false;
+    }
+
+    *start = position;
+    while (position < text->length) {
+        size_t line_end = corpus__line_end(text, position);
+        if (corpus__line_is(text, position, line_end, '-', 3)) {
+            *end = position;
+            *cursor = line_end + 1;
+            return true;
+        }
+        position = line_end + 1;
+    }
+    return false;
+}
+
+#endif // XONSH_BENCH_CORPUS_H_
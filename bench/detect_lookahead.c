@@ -0,0 +1,150 @@
+/**
+ * Lookahead cost of bare subprocess detection.
+ *
+ * Runs detect_subprocess_line at every statement-like line start of the given
+ * corpus files, plus a set of synthetic long lines, and reports how many
+ * characters detection inspected per statement.
+ *
+ *   bench/detect_lookahead test/corpus/<file>.txt ...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/scanner.c"
+
+#include "../src/buffer_lexer.h"
+#include "corpus.h"
+
+#include <time.h>
+
+typedef struct {
+    uint64_t statements;
+    uint64_t characters;
+    uint64_t inspected;
+    uint64_t nanoseconds;
+} LookaheadStats;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void detect_at(LookaheadStats *stats, const char *data, size_t length, size_t position) {
+    BufferLexer lexer = {0};
+    buffer_lexer_reset(&lexer, data, length, position);
+
+    size_t macro_end = 0;
+    Delimiter delimiter = new_delimiter();
+    uint64_t start = now_ns();
+    detect_subprocess_line(&lexer.lexer, &macro_end, &delimiter);
+    stats->nanoseconds += now_ns() - start;
+
+    const char *newline = memchr(&data[position], '\n', length - position);
+    stats->characters += newline ? (uint64_t)(newline - &data[position]) : length - position;
+    stats->inspected += lexer.advances;
+    stats->statements++;
+}
+
+/**
+ * Run detection at each line start of `data[start..end)` the scanner would
+ * consider: not blank, not a comment, not starting with a quote.
+ */
+static void detect_lines(LookaheadStats *stats, const char *data, size_t start, size_t end) {
+    size_t position = start;
+    while (position < end) {
+        while (position < end && (data[position] == ' ' || data[position] == '\t')) {
+            position++;
+        }
+        char c = position < end ? data[position] : '\n';
+        if (c != '\n' && c != '#' && c != '"' && c != '\'') {
+            detect_at(stats, data, end, position);
+        }
+        const char *newline = memchr(&data[position], '\n', end - position);
+        position = newline ? (size_t)(newline - data) + 1 : end;
+    }
+}
+
+static void report(const char *name, const LookaheadStats *stats) {
+    double per_statement = stats->statements ? (double)stats->inspected / (double)stats->statements : 0;
+    double ratio = stats->characters ? (double)stats->inspected / (double)stats->characters : 0;
+    double ns = stats->statements ? (double)stats->nanoseconds / (double)stats->statements : 0;
+    printf("%-32s %8llu %12llu %12llu %10.1f %8.3f %10.1f\n", name,
+           (unsigned long long)stats->statements, (unsigned long long)stats->characters,
+           (unsigned long long)stats->inspected, per_statement, ratio, ns);
+}
+
+typedef struct {
+    const char *name;
+    const char *head;
+    const char *repeat;
+    const char *tail;
+} SyntheticLine;
+
+static const SyntheticLine synthetic_lines[] = {
+    {"long-assignment", "result = ", "value + ", "value"},
+    {"long-call", "process(", "argument, ", "argument)"},
+    {"long-attribute-chain", "config.", "section.", "value"},
+    {"long-flags", "ls -la ", "file.txt ", ""},
+    {"long-pipeline", "cat log.txt ", "| grep pattern ", "| wc -l"},
+    {"long-bare-words", "mycommand ", "word ", "word"},
+    {"long-python-expression", "value ", "+ other ", "+ value"},
+};
+
+static void run_synthetic(size_t repeats) {
+    for (size_t i = 0; i < sizeof(synthetic_lines) / sizeof(synthetic_lines[0]); i++) {
+        const SyntheticLine *line = &synthetic_lines[i];
+        size_t head = strlen(line->head), repeat = strlen(line->repeat), tail = strlen(line->tail);
+        size_t length = head + repeat * repeats + tail + 1;
+        char *data = malloc(length + 1);
+        char *cursor = data;
+        memcpy(cursor, line->head, head);
+        cursor += head;
+        for (size_t r = 0; r < repeats; r++) {
+            memcpy(cursor, line->repeat, repeat);
+            cursor += repeat;
+        }
+        memcpy(cursor, line->tail, tail);
+        cursor += tail;
+        *cursor++ = '\n';
+        *cursor = '\0';
+
+        LookaheadStats stats = {0};
+        for (int run = 0; run < 100; run++) {
+            detect_at(&stats, data, length, 0);
+        }
+        report(line->name, &stats);
+        free(data);
+    }
+}
+
+int main(int argc, char **argv) {
+    printf("%-32s %8s %12s %12s %10s %8s %10s\n", "input", "stmts", "line_chars", "inspected",
+           "per_stmt", "ratio", "ns/stmt");
+
+    LookaheadStats total = {0};
+    for (int i = 1; i < argc; i++) {
+        SourceText text;
+        if (!source_text_read(argv[i], &text)) {
+            return 1;
+        }
+        LookaheadStats stats = {0};
+        size_t cursor = 0, start, end;
+        while (corpus_next_input(&text, &cursor, &start, &end)) {
+            detect_lines(&stats, text.data, start, end);
+        }
+        const char *name = strrchr(argv[i], '/');
+        report(name ? name + 1 : argv[i], &stats);
+        total.statements += stats.statements;
+        total.characters += stats.characters;
+        total.inspected += stats.inspected;
+        total.nanoseconds += stats.nanoseconds;
+        source_text_free(&text);
+    }
+    if (argc > 1) {
+        report("corpus-total", &total);
+    }
+
+    run_synthetic(500);
+    return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * GLR stack versions per parse.
+ *
+ * Links libtree-sitter-xonsh.a and the tree-sitter runtime, parses the test
+ * inputs of the given corpus files plus generated inputs (see generate.h) with
+ * the parser's debug log on, and reads the stack version count tree-sitter
+ * logs before processing each token. A token processed while more than one
+ * version is alive means the parse had forked there. Prints one JSON object
+ * per corpus file or generated input:
+ *
+ *   {"input":"subprocess.txt","inputs":...,"forked_inputs":0,"tokens":...,
+ *    "forked_tokens":0,"max_versions":1}
+ *
+ * forked_tokens counts each token once, however many versions processed it.
+ * With --inputs it also prints the test inputs that forked, by title, with the
+ * row of their first forked token, to find which grammar rule to look at:
+ *
+ *   bench/fork_count [--inputs] [--size BYTES] test/corpus/<file>.txt ...
+ */
+
+#include <tree_sitter/api.h>
+
+#include "tree-sitter-xonsh.h"
+
+#include "corpus.h"
+#include "generate.h"
+
+#include <stdint.h>
+
+typedef struct {
+    uint64_t tokens;
+    uint64_t forked_tokens;
+    uint32_t max_versions;
+    uint32_t first_forked_row;
+} ForkCount;
+
+/**
+ * TSLogger callback. Parse lines that start processing a token look like
+ * "process version:0, version_count:2, state:14, row:3, col:0"; every version
+ * logs one, so only version 0's are counted.
+ */
+static void log_line(void *payload, TSLogType type, const char *line) {
+    ForkCount *count = payload;
+    unsigned version, version_count, row;
+    int state;
+    if (type != TSLogTypeParse ||
+        sscanf(line, "process version:%u, version_count:%u, state:%d, row:%u", &version, &version_count, &state,
+               &row) != 4 ||
+        version != 0) {
+        return;
+    }
+    count->tokens++;
+    if (version_count > 1) {
+        if (count->forked_tokens == 0) {
+            count->first_forked_row = row;
+        }
+        count->forked_tokens++;
+    }
+    if (version_count > count->max_versions) {
+        count->max_versions = version_count;
+    }
+}
+
+static ForkCount count_forks(TSParser *parser, const char *source, size_t length) {
+    ForkCount count = {0, 0, 0, 0};
+    TSLogger logger = {&count, log_line};
+    ts_parser_set_logger(parser, logger);
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source, (uint32_t)length);
+    ts_parser_set_logger(parser, (TSLogger){NULL, NULL});
+    ts_tree_delete(tree);
+    return count;
+}
+
+static void report(const char *input, uint64_t inputs, uint64_t forked_inputs, const ForkCount *total) {
+    printf("{\"input\":\"%s\",\"inputs\":%llu,\"forked_inputs\":%llu,\"tokens\":%llu,\"forked_tokens\":%llu,"
+           "\"max_versions\":%u}\n",
+           input, (unsigned long long)inputs, (unsigned long long)forked_inputs, (unsigned long long)total->tokens,
+           (unsigned long long)total->forked_tokens, total->max_versions);
+    fflush(stdout);
+}
+
+static size_t line_start(const SourceText *text, size_t position) {
+    while (position > 0 && text->data[position - 1] != '\n') {
+        position--;
+    }
+    return position;
+}
+
+/**
+ * The title line of the test whose input starts at `start`: the line after
+ * the first of the two `===` lines above it.
+ */
+static void print_title(const SourceText *text, size_t start) {
+    size_t line = line_start(text, start - 1);  // the second `===` line
+    while (line > 0) {
+        size_t previous = line_start(text, line - 1);
+        if (text->data[previous] == '=') {
+            break;
+        }
+        line = previous;
+    }
+    size_t end = corpus__line_end(text, line);
+    printf("%.*s", (int)(end - line), &text->data[line]);
+}
+
+static bool run_corpus_file(TSParser *parser, const char *path, bool list_inputs) {
+    SourceText text;
+    if (!source_text_read(path, &text)) {
+        return false;
+    }
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    ForkCount total = {0, 0, 0, 0};
+    uint64_t inputs = 0, forked_inputs = 0;
+    size_t cursor = 0, start, end;
+    while (corpus_next_input(&text, &cursor, &start, &end)) {
+        ForkCount count = count_forks(parser, &text.data[start], end - start);
+        inputs++;
+        total.tokens += count.tokens;
+        total.forked_tokens += count.forked_tokens;
+        if (count.max_versions > total.max_versions) {
+            total.max_versions = count.max_versions;
+        }
+        if (count.forked_tokens == 0) {
+            continue;
+        }
+        forked_inputs++;
+        if (list_inputs) {
+            printf("  %s: ", name);
+            print_title(&text, start);
+            printf(" (%llu forked tokens, %u versions, first at row %u)\n",
+                   (unsigned long long)count.forked_tokens, count.max_versions, count.first_forked_row);
+        }
+    }
+
+    report(name, inputs, forked_inputs, &total);
+    source_text_free(&text);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bool list_inputs = false;
+    size_t size = 1 << 16;
+
+    TSParser *parser = ts_parser_new();
+    if (!ts_parser_set_language(parser, tree_sitter_xonsh())) {
+        fprintf(stderr, "incompatible tree-sitter-xonsh language version\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--inputs") == 0) {
+            list_inputs = true;
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (!run_corpus_file(parser, argv[i], list_inputs)) {
+            return 1;
+        }
+    }
+
+    for (int kind = 0; kind < INPUT_KIND_COUNT; kind++) {
+        TextBuffer source = {0};
+        generate_input(&source, (GeneratedInput)kind, size);
+        ForkCount count = count_forks(parser, source.data, source.length);
+        report(generated_input_names[kind], 1, count.forked_tokens ? 1 : 0, &count);
+        text_buffer_free(&source);
+    }
+
+    ts_parser_delete(parser);
+    return 0;
+}
@@ -0,0 +1,297 @@
+/**
+ * Generated benchmark inputs.
+ *
+ * The corpus covers syntax, not scale: its test inputs are a few lines each.
+ * These generators build large xonsh sources that stress particular parts of
+ * the grammar and scanner, each repeated until it reaches a target size.
+ */
+
+#ifndef XONSH_BENCH_GENERATE_H_
+#define XONSH_BENCH_GENERATE_H_
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} TextBuffer;
+
+static inline void text_buffer_append(TextBuffer *self, const char *text, size_t length) {
+    if (self->length + length + 1 > self->capacity) {
+        size_t capacity = self->capacity ? self->capacity : 4096;
+        while (self->length + length + 1 > capacity) {
+            capacity *= 2;
+        }
+        self->data = realloc(self->data, capacity);
+        self->capacity = capacity;
+    }
+    memcpy(&self->data[self->length], text, length);
+    self->length += length;
+    self->data[self->length] = '\0';
+}
+
+static inline void text_buffer_printf(TextBuffer *self, const char *format, ...) {
+    char line[1024];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length > 0) {
+        text_buffer_append(self, line, (size_t)length < sizeof(line) ? (size_t)length : sizeof(line) - 1);
+    }
+}
+
+static inline void text_buffer_indent(TextBuffer *self, unsigned depth) {
+    for (unsigned i = 0; i < depth; i++) {
+        text_buffer_append(self, "    ", 4);
+    }
+}
+
+static inline void text_buffer_free(TextBuffer *self) {
+    free(self->data);
+    self->data = NULL;
+    self->length = self->capacity = 0;
+}
+
+/**
+ * Blocks nested `depth` levels deep, each level an if/for/with/def, with a
+ * mix of Python and subprocess statements at the bottom.
+ */
+static inline void generate_deep_indent(TextBuffer *out, unsigned depth) {
+    static const char *const openers[] = {"if x%u:", "for i%u in range(3):", "with open(f%u) as h:",
+                                          "def f%u():", "while y%u:"};
+    for (unsigned level = 0; level < depth; level++) {
+        text_buffer_indent(out, level);
+        text_buffer_printf(out, openers[level % 5], level);
+        text_buffer_append(out, "\n", 1);
+    }
+    text_buffer_indent(out, depth);
+    text_buffer_append(out, "total = compute(a, b) + 1\n", 26);
+    text_buffer_indent(out, depth);
+    text_buffer_append(out, "ls -la $HOME | grep xsh\n", 24);
+    for (unsigned level = depth; level > 0; level--) {
+        text_buffer_indent(out, level - 1);
+        text_buffer_append(out, "pass\n", 5);
+    }
+}
+
+/**
+ * A bare subprocess pipeline of `stages` commands, with flags, globs,
+ * environment variables and a redirect.
+ */
+static inline void generate_pipeline(TextBuffer *out, unsigned stages, unsigned seed) {
+    static const char *const commands[] = {"grep -v pattern", "sort -u", "uniq -c", "sed -e 's/a/b/g'",
+                                           "awk '{print $1}'", "head -n 20", "tr a-z A-Z", "cut -d: -f1"};
+    text_buffer_printf(out, "cat $HOME/log%u.txt", seed);
+    for (unsigned stage = 0; stage < stages; stage++) {
+        text_buffer_append(out, " | ", 3);
+        const char *command = commands[(seed + stage) % 8];
+        text_buffer_append(out, command, strlen(command));
+    }
+    text_buffer_printf(out, " > out%u.txt\n", seed);
+}
+
+/**
+ * An assignment of a triple-quoted string `lines` lines long, with the odd
+ * quote, escape and interpolation-looking brace inside.
+ */
+static inline void generate_triple_quoted(TextBuffer *out, unsigned lines, unsigned seed) {
+    text_buffer_printf(out, "doc%u = \"\"\"\n", seed);
+    for (unsigned line = 0; line < lines; line++) {
+        text_buffer_printf(out, "line %u with 'quotes', \\\"escapes\\\", {braces} and $VARS | pipes\n", line);
+    }
+    text_buffer_append(out, "\"\"\"\n", 4);
+}
+
+static inline void generate_python_block(TextBuffer *out, unsigned seed) {
+    text_buffer_printf(out,
+                       "class Model%u(Base):\n"
+                       "    def __init__(self, values, *, scale=1.0):\n"
+                       "        self.values = [v * scale for v in values if v is not None]\n"
+                       "        self.index = {k: i for i, k in enumerate(self.values)}\n"
+                       "\n"
+                       "    def total(self) -> float:\n"
+                       "        return sum(x ** 2 for x in self.values) / max(len(self.values), 1)\n"
+                       "\n",
+                       seed);
+    text_buffer_printf(out,
+                       "result%u = Model%u([1, 2, 3], scale=0.5).total()\n"
+                       "config = {'name': f\"model-{result%u:.2f}\", 'items': [a, b, c][1:]}\n"
+                       "history = []\n"
+                       "if result%u >= 1 and not config.get('skip'):\n"
+                       "    history.append((result%u, config))\n",
+                       seed, seed, seed, seed, seed);
+}
+
+static inline void generate_shell_block(TextBuffer *out, unsigned seed) {
+    text_buffer_printf(out,
+                       "cd $HOME/projects/p%u\n"
+                       "git status --short | grep -v '^ D' | wc -l\n"
+                       "ls -la *.py > files%u.txt 2>&1\n"
+                       "make -j4 all && echo done || echo failed\n"
+                       "$PATH.append('/opt/bin%u')\n"
+                       "echo @(result) $(whoami) ![ls -1] &\n"
+                       "tar -czf backup%u.tar.gz ./src --exclude=*.o\n",
+                       seed, seed, seed, seed);
+}
+
+/**
+ * Python and shell blocks interleaved, `python_percent` of them Python.
+ */
+static inline void generate_mix(TextBuffer *out, unsigned blocks, unsigned python_percent) {
+    for (unsigned block = 0; block < blocks; block++) {
+        if ((block * 37 % 100) < python_percent) {
+            generate_python_block(out, block);
+        } else {
+            generate_shell_block(out, block);
+        }
+    }
+}
+
+typedef enum {
+    INPUT_DEEP_INDENT,
+    INPUT_LONG_PIPELINES,
+    INPUT_TRIPLE_QUOTED,
+    INPUT_PYTHON_HEAVY,
+    INPUT_SHELL_HEAVY,
+    INPUT_BALANCED_MIX,
+    INPUT_KIND_COUNT,
+} GeneratedInput;
+
+static const char *const generated_input_names[INPUT_KIND_COUNT] = {
+    "deep-indent", "long-pipelines", "triple-quoted", "python-heavy", "shell-heavy", "balanced-mix",
+};
+
+/**
+ * Build about `size` bytes of the given kind of input into `out`.
+ */
+static inline void generate_input(TextBuffer *out, GeneratedInput kind, size_t size) {
+    for (unsigned seed = 0; out->length < size; seed++) {
+        switch (kind) {
+            case INPUT_DEEP_INDENT:
+                generate_deep_indent(out, 40 + seed % 40);
+                break;
+            case INPUT_LONG_PIPELINES:
+                generate_pipeline(out, 20 + seed % 30, seed);
+                break;
+            case INPUT_TRIPLE_QUOTED:
+                generate_triple_quoted(out, 500, seed);
+                break;
+            case INPUT_PYTHON_HEAVY:
+                generate_mix(out, 10, 90);
+                break;
+            case INPUT_SHELL_HEAVY:
+                generate_mix(out, 10, 10);
+                break;
+            case INPUT_BALANCED_MIX:
+                generate_mix(out, 10, 50);
+                break;
+            default:
+                return;
+        }
+    }
+}
+
+/*
+ * Adversarial inputs.
+ *
+ * Each builds one pathological structure that grows with `size` (a single
+ * longer line, a deeper nesting, a longer comment run), rather than
+ * repeating a small one, so that work super-linear in the structure shows up
+ * as super-linear in the input size. test/scanner/scaling and
+ * test/parse/scaling run them at growing sizes.
+ */
+
+typedef enum {
+    ADVERSARIAL_UNCLOSED_QUOTES,
+    ADVERSARIAL_NESTED_EVAL,
+    ADVERSARIAL_COMMENT_RUN,
+    ADVERSARIAL_BRACE_EXPANSION,
+    ADVERSARIAL_UNDECIDED_LINE,
+    ADVERSARIAL_KIND_COUNT,
+} AdversarialInput;
+
+static const char *const adversarial_input_names[ADVERSARIAL_KIND_COUNT] = {
+    "unclosed-quotes", "nested-eval", "comment-run", "brace-expansion", "undecided-line",
+};
+
+/**
+ * Build about `size` bytes of the given adversarial input into `out`.
+ */
+static inline void generate_adversarial(TextBuffer *out, AdversarialInput kind, size_t size) {
+    size_t end = out->length + size;
+    switch (kind) {
+        case ADVERSARIAL_UNCLOSED_QUOTES:
+            // Lines of quotes that never close, then one triple quote that
+            // runs to the end of the input
+            for (unsigned line = 0; out->length < end; line++) {
+                text_buffer_printf(out, line % 2 ? "echo \"it's %u 'a \"b 'c \"d 'e\n"
+                                                 : "x%u = f\"{a} 'b \\\" 'c {d!r:>{w}} 'e\n",
+                                   line);
+            }
+            text_buffer_append(out, "doc = \"\"\"\nnever closed\n", 23);
+            break;
+        case ADVERSARIAL_NESTED_EVAL: {
+            // One statement of @(...) nested as deep as the size allows, up to
+            // a depth tree-sitter's stack handles, then more of them
+            size_t depth = size / 16 < 10000 ? size / 16 : 10000;
+            while (out->length < end) {
+                text_buffer_append(out, "echo", 4);
+                for (size_t level = 0; level < depth; level++) {
+                    text_buffer_append(out, " @(f(x,", 7);
+                }
+                text_buffer_append(out, " 1", 2);
+                for (size_t level = 0; level < depth; level++) {
+                    text_buffer_append(out, "))", 2);
+                }
+                text_buffer_append(out, "\n", 1);
+            }
+            break;
+        }
+        case ADVERSARIAL_COMMENT_RUN:
+            // A single run of comment lines at the indentation of the block
+            // around it
+            text_buffer_append(out, "def f():\n    x = 1\n", 19);
+            for (unsigned line = 0; out->length < end; line++) {
+                text_buffer_printf(out, "    # step %u: ls -la | grep 'x' && echo \"done\"\n", line);
+            }
+            text_buffer_append(out, "    return x\n", 13);
+            break;
+        case ADVERSARIAL_BRACE_EXPANSION: {
+            // One flat brace expansion, then one nested as deep as the rest
+            // of the size allows
+            size_t half = out->length + size / 2;
+            text_buffer_append(out, "echo file{", 10);
+            for (unsigned item = 0; out->length < half; item++) {
+                text_buffer_printf(out, "%sa%u", item ? "," : "", item);
+            }
+            text_buffer_append(out, "}.txt\necho x", 12);
+            size_t depth = 0;
+            for (; out->length + 2 * depth < end; depth++) {
+                text_buffer_append(out, "{a,b", 4);
+            }
+            for (size_t level = 0; level < depth; level++) {
+                text_buffer_append(out, "}", 1);
+            }
+            text_buffer_append(out, "\n", 1);
+            break;
+        }
+        case ADVERSARIAL_UNDECIDED_LINE:
+            // One line of bare words with no signal that decides it, so
+            // detection keeps reading
+            text_buffer_append(out, "mycommand", 9);
+            for (unsigned word = 0; out->length < end; word++) {
+                text_buffer_printf(out, " word%u", word);
+            }
+            text_buffer_append(out, "\n", 1);
+            break;
+        default:
+            break;
+    }
+}
+
+#endif // XONSH_BENCH_GENERATE_H_
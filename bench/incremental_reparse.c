@@ -0,0 +1,274 @@
+/**
+ * Incremental reparse latency under editor-style keystrokes.
+ *
+ * Loads a large xonsh source (a file given on the command line, or about
+ * 256 KB of generated Python/shell mix), then replays edit scripts one
+ * keystroke at a time: each keystroke edits the buffer, calls ts_tree_edit on
+ * the previous tree and reparses with it, the way an editor integration does.
+ * Prints one JSON object per script with reparse latency percentiles and the
+ * size of the ranges tree-sitter reports as changed:
+ *
+ *   {"script":"type-subprocess-args","keystrokes":24,"p50_us":...,"p90_us":...,
+ *    "p99_us":...,"max_us":...,"mean_changed_bytes":...,"max_changed_bytes":...}
+ *
+ *   bench/incremental_reparse [--rounds N] [file.xsh]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <tree_sitter/api.h>
+
+#include "tree-sitter-xonsh.h"
+
+#include "corpus.h"
+#include "generate.h"
+
+#include <stdint.h>
+#include <time.h>
+
+typedef struct {
+    TSParser *parser;
+    TSTree *tree;
+    TextBuffer source;
+    uint64_t *latencies;
+    uint64_t *changed_bytes;
+    size_t keystrokes;
+    size_t capacity;
+} Session;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static TSPoint point_at(const TextBuffer *source, size_t offset) {
+    TSPoint point = {0, 0};
+    for (size_t i = 0; i < offset; i++) {
+        if (source->data[i] == '\n') {
+            point.row++;
+            point.column = 0;
+        } else {
+            point.column++;
+        }
+    }
+    return point;
+}
+
+static TSTree *parse(Session *session, TSTree *old_tree) {
+    return ts_parser_parse_string(session->parser, old_tree, session->source.data, (uint32_t)session->source.length);
+}
+
+/**
+ * Replace `removed` bytes at `offset` with `inserted`, then reparse
+ * incrementally and record the latency and changed ranges.
+ */
+static void keystroke(Session *session, size_t offset, size_t removed, const char *inserted, size_t inserted_length) {
+    TextBuffer *source = &session->source;
+    TSInputEdit edit;
+    edit.start_byte = (uint32_t)offset;
+    edit.old_end_byte = (uint32_t)(offset + removed);
+    edit.new_end_byte = (uint32_t)(offset + inserted_length);
+    edit.start_point = point_at(source, offset);
+    edit.old_end_point = point_at(source, offset + removed);
+
+    size_t tail = source->length - offset - removed;
+    if (inserted_length > removed) {
+        size_t growth = inserted_length - removed;
+        text_buffer_append(source, inserted, growth);  // only to make room
+    }
+    memmove(&source->data[offset + inserted_length], &source->data[offset + removed], tail);
+    memcpy(&source->data[offset], inserted, inserted_length);
+    source->length = offset + inserted_length + tail;
+    source->data[source->length] = '\0';
+    edit.new_end_point = point_at(source, offset + inserted_length);
+
+    uint64_t start = now_ns();
+    ts_tree_edit(session->tree, &edit);
+    TSTree *tree = parse(session, session->tree);
+    uint64_t elapsed = now_ns() - start;
+
+    uint32_t range_count;
+    TSRange *ranges = ts_tree_get_changed_ranges(session->tree, tree, &range_count);
+    uint64_t changed = 0;
+    for (uint32_t i = 0; i < range_count; i++) {
+        changed += ranges[i].end_byte - ranges[i].start_byte;
+    }
+    free(ranges);
+    ts_tree_delete(session->tree);
+    session->tree = tree;
+
+    if (session->keystrokes == session->capacity) {
+        session->capacity = session->capacity ? session->capacity * 2 : 256;
+        session->latencies = realloc(session->latencies, session->capacity * sizeof(uint64_t));
+        session->changed_bytes = realloc(session->changed_bytes, session->capacity * sizeof(uint64_t));
+    }
+    session->latencies[session->keystrokes] = elapsed;
+    session->changed_bytes[session->keystrokes] = changed;
+    session->keystrokes++;
+}
+
+static void type_text(Session *session, size_t offset, const char *text) {
+    for (size_t i = 0; text[i]; i++) {
+        keystroke(session, offset + i, 0, &text[i], 1);
+    }
+}
+
+static void backspace(Session *session, size_t offset, size_t count) {
+    for (size_t i = count; i > 0; i--) {
+        keystroke(session, offset + i - 1, 1, "", 0);
+    }
+}
+
+/**
+ * Offset of the first line starting with `prefix` at or after the middle of
+ * the source, falling back to the start of the file.
+ */
+static size_t find_line(const TextBuffer *source, const char *prefix) {
+    size_t length = strlen(prefix);
+    for (size_t from = source->length / 2;; from = 0) {
+        for (size_t i = from; i + length <= source->length; i++) {
+            if ((i == 0 || source->data[i - 1] == '\n') && memcmp(&source->data[i], prefix, length) == 0) {
+                return i;
+            }
+        }
+        if (from == 0) {
+            return 0;
+        }
+    }
+}
+
+static size_t line_end(const TextBuffer *source, size_t offset) {
+    const char *newline = memchr(&source->data[offset], '\n', source->length - offset);
+    return newline ? (size_t)(newline - source->data) : source->length;
+}
+
+/*
+ * Edit scripts. Each leaves the buffer as it found it, so scripts and rounds
+ * can follow each other.
+ */
+
+static void script_type_subprocess_args(Session *session) {
+    static const char args[] = " --color=auto | wc -l";
+    size_t end = line_end(&session->source, find_line(&session->source, "ls -la"));
+    type_text(session, end, args);
+    backspace(session, end, strlen(args));
+}
+
+static void script_type_python_expression(Session *session) {
+    static const char item[] = "len(items) * 2";
+    // Inside the brackets of `history = []`
+    size_t end = line_end(&session->source, find_line(&session->source, "history = []"));
+    type_text(session, end - 1, item);
+    backspace(session, end - 1, strlen(item));
+}
+
+static void script_add_indentation(Session *session) {
+    static const char opener[] = "if ready:\n";
+    size_t line = find_line(&session->source, "make -j4");
+    size_t body = line + strlen(opener);
+    type_text(session, line, opener);
+    type_text(session, body, "    ");
+    backspace(session, body, 4);
+    backspace(session, line, strlen(opener));
+}
+
+static void script_triple_quoted_f_string(Session *session) {
+    static const char *const parts[] = {"notes = f\"\"\"\n", "build {name} on $HOST\n", "\"\"\"\n"};
+    size_t line = find_line(&session->source, "cd $HOME");
+    size_t offset = line;
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+        type_text(session, offset, parts[i]);
+        offset += strlen(parts[i]);
+    }
+    backspace(session, line, offset - line);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(Session *session);
+} Script;
+
+static const Script scripts[] = {
+    {"type-subprocess-args", script_type_subprocess_args},
+    {"type-python-expression", script_type_python_expression},
+    {"add-indentation", script_add_indentation},
+    {"triple-quoted-f-string", script_triple_quoted_f_string},
+};
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint64_t *sorted, size_t count, double percentile) {
+    size_t index = (size_t)(percentile / 100.0 * (double)(count - 1) + 0.5);
+    return (double)sorted[index] / 1000.0;
+}
+
+static void report(const char *name, Session *session) {
+    size_t count = session->keystrokes;
+    if (count == 0) {
+        return;
+    }
+    uint64_t changed_total = 0, changed_max = 0;
+    for (size_t i = 0; i < count; i++) {
+        changed_total += session->changed_bytes[i];
+        if (session->changed_bytes[i] > changed_max) {
+            changed_max = session->changed_bytes[i];
+        }
+    }
+    qsort(session->latencies, count, sizeof(uint64_t), compare_u64);
+    printf("{\"script\":\"%s\",\"keystrokes\":%zu,\"p50_us\":%.1f,\"p90_us\":%.1f,\"p99_us\":%.1f,"
+           "\"max_us\":%.1f,\"mean_changed_bytes\":%.1f,\"max_changed_bytes\":%llu}\n",
+           name, count, percentile_us(session->latencies, count, 50), percentile_us(session->latencies, count, 90),
+           percentile_us(session->latencies, count, 99), (double)session->latencies[count - 1] / 1000.0,
+           (double)changed_total / (double)count, (unsigned long long)changed_max);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    unsigned rounds = 20;
+    Session session = {0};
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else {
+            SourceText file;
+            if (!source_text_read(argv[i], &file)) {
+                return 1;
+            }
+            text_buffer_append(&session.source, file.data, file.length);
+            source_text_free(&file);
+        }
+    }
+    if (session.source.length == 0) {
+        generate_input(&session.source, INPUT_BALANCED_MIX, 256 * 1024);
+    }
+
+    session.parser = ts_parser_new();
+    if (!ts_parser_set_language(session.parser, tree_sitter_xonsh())) {
+        fprintf(stderr, "incompatible tree-sitter-xonsh language version\n");
+        return 1;
+    }
+    uint64_t start = now_ns();
+    session.tree = parse(&session, NULL);
+    printf("{\"initial_parse_bytes\":%zu,\"initial_parse_us\":%.1f}\n", session.source.length,
+           (double)(now_ns() - start) / 1000.0);
+
+    for (size_t s = 0; s < sizeof(scripts) / sizeof(scripts[0]); s++) {
+        session.keystrokes = 0;
+        for (unsigned round = 0; round < rounds; round++) {
+            scripts[s].run(&session);
+        }
+        report(scripts[s].name, &session);
+    }
+
+    ts_tree_delete(session.tree);
+    ts_parser_delete(session.parser);
+    text_buffer_free(&session.source);
+    free(session.latencies);
+    free(session.changed_bytes);
+    return 0;
+}
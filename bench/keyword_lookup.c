@@ -0,0 +1,157 @@
+/**
+ * Keyword and shell command lookup microbenchmark.
+ *
+ * Compares the generated lookups in src/scanner_tables.h against the linear
+ * strlen/strncmp walk over NULL-terminated arrays they replaced. Candidates
+ * are every identifier in the given corpus files plus every listed word, so
+ * both hits and misses are measured. Run from the repository root:
+ *
+ *   bench/keyword_lookup test/corpus/<file>.txt ...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/scanner_tables.h"
+
+#include "corpus.h"
+
+#include <stdint.h>
+#include <time.h>
+
+typedef bool (*LookupFn)(const char *ident, size_t len);
+
+typedef struct {
+    const char *name;
+    const char *list;
+    LookupFn generated;
+    const char **words;
+} Table;
+
+typedef struct {
+    const char *text;
+    size_t length;
+} Candidate;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Load a word list into a NULL-terminated array, the layout the scanner used
+ * before the tables were generated.
+ */
+static const char **load_words(const char *list, SourceText *text) {
+    char path[256];
+    snprintf(path, sizeof(path), "src/wordlists/%s", list);
+    if (!source_text_read(path, text)) {
+        exit(1);
+    }
+    size_t count = 0, capacity = 16;
+    const char **words = malloc(capacity * sizeof(char *));
+    char *line = strtok(text->data, "\n");
+    while (line) {
+        while (*line == ' ' || *line == '\t') line++;
+        if (*line && *line != '#') {
+            if (count + 2 > capacity) {
+                capacity *= 2;
+                words = realloc(words, capacity * sizeof(char *));
+            }
+            words[count++] = line;
+        }
+        line = strtok(NULL, "\n");
+    }
+    words[count] = NULL;
+    return words;
+}
+
+static const char **legacy_words;
+
+static bool legacy_lookup(const char *ident, size_t len) {
+    for (int i = 0; legacy_words[i] != NULL; i++) {
+        size_t word_len = strlen(legacy_words[i]);
+        if (word_len == len && strncmp(ident, legacy_words[i], len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_ident_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static void push_candidate(Candidate **candidates, size_t *count, size_t *capacity, const char *text, size_t length) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 1024;
+        *candidates = realloc(*candidates, *capacity * sizeof(Candidate));
+    }
+    (*candidates)[(*count)++] = (Candidate){text, length};
+}
+
+static double run(LookupFn lookup, const Candidate *candidates, size_t count, int rounds, size_t *hits) {
+    *hits = 0;
+    uint64_t start = now_ns();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < count; i++) {
+            *hits += lookup(candidates[i].text, candidates[i].length);
+        }
+    }
+    return (double)(now_ns() - start) / ((double)count * rounds);
+}
+
+int main(int argc, char **argv) {
+    Table tables[] = {
+        {"python_keywords", "python_keywords.txt", is_python_keyword, NULL},
+        {"python_operator_keywords", "python_operator_keywords.txt", is_python_operator_keyword, NULL},
+        {"shell_commands", "shell_commands.txt", is_shell_command, NULL},
+    };
+    size_t table_count = sizeof(tables) / sizeof(tables[0]);
+    SourceText lists[sizeof(tables) / sizeof(tables[0])];
+
+    Candidate *candidates = NULL;
+    size_t count = 0, capacity = 0;
+    for (size_t t = 0; t < table_count; t++) {
+        tables[t].words = load_words(tables[t].list, &lists[t]);
+        for (const char **word = tables[t].words; *word; word++) {
+            push_candidate(&candidates, &count, &capacity, *word, strlen(*word));
+        }
+    }
+
+    SourceText *sources = calloc((size_t)argc, sizeof(SourceText));
+    for (int i = 1; i < argc; i++) {
+        if (!source_text_read(argv[i], &sources[i])) {
+            return 1;
+        }
+        size_t cursor = 0, start, end;
+        while (corpus_next_input(&sources[i], &cursor, &start, &end)) {
+            for (size_t p = start; p < end;) {
+                if (is_ident_char(sources[i].data[p])) {
+                    size_t word_start = p;
+                    while (p < end && is_ident_char(sources[i].data[p])) p++;
+                    push_candidate(&candidates, &count, &capacity, &sources[i].data[word_start], p - word_start);
+                } else {
+                    p++;
+                }
+            }
+        }
+    }
+
+    int rounds = (int)(20000000 / count) + 1;
+    printf("%-28s %10s %8s %12s %12s %8s\n", "table", "lookups", "hits", "legacy_ns", "generated_ns", "speedup");
+    for (size_t t = 0; t < table_count; t++) {
+        legacy_words = tables[t].words;
+        size_t legacy_hits, generated_hits;
+        double legacy_ns = run(legacy_lookup, candidates, count, rounds, &legacy_hits);
+        double generated_ns = run(tables[t].generated, candidates, count, rounds, &generated_hits);
+        if (legacy_hits != generated_hits) {
+            fprintf(stderr, "%s: generated lookup disagrees with the word list (%zu vs %zu hits)\n",
+                    tables[t].name, generated_hits, legacy_hits);
+            return 1;
+        }
+        printf("%-28s %10zu %8zu %12.2f %12.2f %7.1fx\n", tables[t].name, count,
+               legacy_hits / (size_t)rounds, legacy_ns, generated_ns, legacy_ns / generated_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * Parse throughput of the full grammar.
+ *
+ * Links libtree-sitter-xonsh.a and the tree-sitter runtime, and parses the
+ * test inputs of the given corpus files plus generated large inputs (see
+ * generate.h). Prints one JSON object per line so results can be diffed or
+ * collected between releases:
+ *
+ *   {"input":"deep-indent","bytes":1048576,"runs":12,"ns_per_byte":...,
+ *    "mb_per_s":...,"has_error":false,"peak_rss_kb":...}
+ *
+ * Timings are the best of at least `--runs` parses (and at least a fifth of
+ * a second of parsing). peak_rss_kb is the process high-water mark after the
+ * input, so it only grows from line to line. Run `make bench`, or:
+ *
+ *   bench/parse_throughput [--runs N] [--size BYTES] test/corpus/<file>.txt ...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <tree_sitter/api.h>
+
+#include "tree-sitter-xonsh.h"
+
+#include "corpus.h"
+#include "generate.h"
+
+#include <stdint.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define MIN_NANOSECONDS 200000000u
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t best_ns;
+    uint64_t runs;
+    bool has_error;
+} Throughput;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * Parse each of `count` sources once per run, keeping the fastest run.
+ */
+static Throughput measure(TSParser *parser, const char *const *sources, const size_t *lengths, size_t count,
+                          unsigned min_runs) {
+    Throughput result = {0, UINT64_MAX, 0, false};
+    for (size_t i = 0; i < count; i++) {
+        result.bytes += lengths[i];
+    }
+    uint64_t elapsed = 0;
+    while (result.runs < min_runs || elapsed < MIN_NANOSECONDS) {
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < count; i++) {
+            TSTree *tree = ts_parser_parse_string(parser, NULL, sources[i], (uint32_t)lengths[i]);
+            if (result.runs == 0 && ts_node_has_error(ts_tree_root_node(tree))) {
+                result.has_error = true;
+            }
+            ts_tree_delete(tree);
+        }
+        uint64_t run_ns = now_ns() - start;
+        elapsed += run_ns;
+        if (run_ns < result.best_ns) {
+            result.best_ns = run_ns;
+        }
+        result.runs++;
+    }
+    return result;
+}
+
+static void report(const char *input, const Throughput *result) {
+    double ns_per_byte = result->bytes ? (double)result->best_ns / (double)result->bytes : 0;
+    double mb_per_s = result->best_ns ? (double)result->bytes / 1e6 / ((double)result->best_ns / 1e9) : 0;
+    printf("{\"input\":\"%s\",\"bytes\":%llu,\"runs\":%llu,\"ns_per_byte\":%.3f,\"mb_per_s\":%.2f,"
+           "\"has_error\":%s,\"peak_rss_kb\":%ld}\n",
+           input, (unsigned long long)result->bytes, (unsigned long long)result->runs, ns_per_byte, mb_per_s,
+           result->has_error ? "true" : "false", peak_rss_kb());
+    fflush(stdout);
+}
+
+static bool run_corpus_file(TSParser *parser, const char *path, unsigned min_runs) {
+    SourceText text;
+    if (!source_text_read(path, &text)) {
+        return false;
+    }
+    size_t capacity = 64, count = 0;
+    const char **sources = malloc(capacity * sizeof(char *));
+    size_t *lengths = malloc(capacity * sizeof(size_t));
+    size_t cursor = 0, start, end;
+    while (corpus_next_input(&text, &cursor, &start, &end)) {
+        if (count == capacity) {
+            capacity *= 2;
+            sources = realloc(sources, capacity * sizeof(char *));
+            lengths = realloc(lengths, capacity * sizeof(size_t));
+        }
+        sources[count] = &text.data[start];
+        lengths[count++] = end - start;
+    }
+
+    Throughput result = measure(parser, sources, lengths, count, min_runs);
+    // Error nodes are expected in a few corpus files, e.g. python_errors.txt
+    const char *name = strrchr(path, '/');
+    report(name ? name + 1 : path, &result);
+
+    free(sources);
+    free(lengths);
+    source_text_free(&text);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    unsigned min_runs = 5;
+    size_t size = 1 << 20;
+
+    TSParser *parser = ts_parser_new();
+    if (!ts_parser_set_language(parser, tree_sitter_xonsh())) {
+        fprintf(stderr, "incompatible tree-sitter-xonsh language version\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            min_runs = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (!run_corpus_file(parser, argv[i], min_runs)) {
+            return 1;
+        }
+    }
+
+    for (int kind = 0; kind < INPUT_KIND_COUNT; kind++) {
+        TextBuffer source = {0};
+        generate_input(&source, (GeneratedInput)kind, size);
+        const char *data = source.data;
+        Throughput result = measure(parser, &data, &source.length, 1, min_runs);
+        report(generated_input_names[kind], &result);
+        text_buffer_free(&source);
+    }
+
+    ts_parser_delete(parser);
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * External scanner create/destroy churn.
+ *
+ * Tree-sitter creates a scanner whenever a parser gets its language and
+ * destroys it with the parser, so a service that builds a parser per request
+ * pays for both on every request. This measures that cost, and how many
+ * allocator calls it makes, in three patterns:
+ *
+ *   back-to-back   create and immediately destroy
+ *   per-request    destroy a random one of 256 live scanners, create a
+ *                  replacement and restore a state into it
+ *   deep-state     like per-request, with states deep enough to spill the
+ *                  inline stacks to the heap
+ *
+ * Built twice: bench/scanner_churn uses plain ts_calloc/ts_free, and
+ * bench/scanner_churn_pool adds TREE_SITTER_XONSH_SCANNER_POOL.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+
+static size_t allocator_calls;
+
+static void *counting_malloc(size_t size) {
+    allocator_calls++;
+    return malloc(size);
+}
+
+static void *counting_calloc(size_t count, size_t size) {
+    allocator_calls++;
+    return calloc(count, size);
+}
+
+static void *counting_realloc(void *ptr, size_t size) {
+    allocator_calls++;
+    return realloc(ptr, size);
+}
+
+static void counting_free(void *ptr) {
+    allocator_calls += ptr != NULL;
+    free(ptr);
+}
+
+#define ts_malloc counting_malloc
+#define ts_calloc counting_calloc
+#define ts_realloc counting_realloc
+#define ts_free counting_free
+
+#include "../src/scanner.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#define LIVE_SCANNERS 256
+#define OPERATIONS 2000000
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t next_random(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static void report(const char *name, uint64_t nanoseconds, size_t calls) {
+    printf("%-24s %10d %10.1f %12.2f\n", name, OPERATIONS, (double)nanoseconds / OPERATIONS,
+           (double)calls / OPERATIONS);
+}
+
+/**
+ * Serialized state `depth` blocks deep, 4 columns each.
+ */
+static unsigned make_state(uint32_t depth, char *buffer) {
+    Scanner *scanner = tree_sitter_xonsh_external_scanner_create();
+    for (uint32_t i = 1; i <= depth; i++) {
+        inline_array_push(&scanner->indents, (uint16_t)(4 * i));
+    }
+    unsigned length = tree_sitter_xonsh_external_scanner_serialize(scanner, buffer);
+    tree_sitter_xonsh_external_scanner_destroy(scanner);
+    return length;
+}
+
+static void run_back_to_back(void) {
+    size_t calls = allocator_calls;
+    uint64_t start = now_ns();
+    for (int i = 0; i < OPERATIONS; i++) {
+        void *scanner = tree_sitter_xonsh_external_scanner_create();
+        tree_sitter_xonsh_external_scanner_destroy(scanner);
+    }
+    report("back-to-back", now_ns() - start, allocator_calls - calls);
+}
+
+static void run_per_request(const char *name, uint32_t depth) {
+    char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+    unsigned length = make_state(depth, state);
+
+    void *live[LIVE_SCANNERS];
+    for (int i = 0; i < LIVE_SCANNERS; i++) {
+        live[i] = tree_sitter_xonsh_external_scanner_create();
+    }
+
+    uint32_t random = 2463534242u;
+    size_t calls = allocator_calls;
+    uint64_t start = now_ns();
+    for (int i = 0; i < OPERATIONS; i++) {
+        uint32_t slot = next_random(&random) % LIVE_SCANNERS;
+        tree_sitter_xonsh_external_scanner_destroy(live[slot]);
+        live[slot] = tree_sitter_xonsh_external_scanner_create();
+        tree_sitter_xonsh_external_scanner_deserialize(live[slot], state, length);
+    }
+    report(name, now_ns() - start, allocator_calls - calls);
+
+    for (int i = 0; i < LIVE_SCANNERS; i++) {
+        tree_sitter_xonsh_external_scanner_destroy(live[i]);
+    }
+}
+
+int main(void) {
+#ifdef TREE_SITTER_XONSH_SCANNER_POOL
+    printf("scanner pool: %d per thread\n", TREE_SITTER_XONSH_SCANNER_POOL_SIZE);
+#else
+    printf("scanner pool: off\n");
+#endif
+    printf("%-24s %10s %10s %12s\n", "pattern", "ops", "ns/op", "alloc_calls");
+    run_back_to_back();
+    run_per_request("per-request", 4);
+    run_per_request("deep-state", 40);
+    tree_sitter_xonsh_scanner_pool_drain();
+    return 0;
+}
@@ -0,0 +1,224 @@
+/**
+ * Size of the external scanner state stored with external tokens.
+ *
+ * Replays the indent stack (and open triple-quoted strings) line by line over
+ * the given corpus files and a few synthetic deep-nesting cases, serializing
+ * the state at each line with both the current encoding and the one-byte-per
+ * entry encoding it replaced. Tree-sitter keeps states of up to 24 bytes
+ * inline in the token and heap-allocates larger ones, so the heap column is
+ * what each encoding adds per parsed tree beyond the token itself. Every
+ * state is also round-tripped through deserialize to check it is lossless.
+ *
+ *   bench/state_size test/corpus/<file>.txt ...
+ */
+
+#include "../src/scanner.c"
+
+#include "corpus.h"
+
+// Largest state tree-sitter stores without a separate allocation
+#define INLINE_STATE_SIZE 24
+
+typedef struct {
+    uint64_t states;
+    uint64_t legacy_bytes;
+    uint64_t legacy_heap;
+    uint64_t legacy_lossy;
+    uint64_t bytes;
+    uint64_t heap;
+    uint64_t lossy;
+} SizeStats;
+
+/**
+ * The encoding used before versioning: f-string flag, a one-byte delimiter
+ * count, the delimiters, then one byte per indent.
+ */
+static unsigned legacy_serialize(Scanner *scanner, char *buffer) {
+    size_t size = 0;
+    buffer[size++] = (char)scanner->inside_f_string;
+    size_t delimiter_count = scanner->delimiters.size;
+    if (delimiter_count > UINT8_MAX) {
+        delimiter_count = UINT8_MAX;
+    }
+    buffer[size++] = (char)delimiter_count;
+    if (delimiter_count > 0) {
+        memcpy(&buffer[size], scanner->delimiters.contents, delimiter_count);
+    }
+    size += delimiter_count;
+    for (uint32_t i = 1; i < scanner->indents.size && size < TREE_SITTER_SERIALIZATION_BUFFER_SIZE; ++i) {
+        buffer[size++] = (char)*array_get(&scanner->indents, i);
+    }
+    return size;
+}
+
+static bool legacy_round_trips(Scanner *scanner, const char *buffer, unsigned length) {
+    size_t delimiter_count = (uint8_t)buffer[1];
+    if (delimiter_count != scanner->delimiters.size || length - 2 - delimiter_count != scanner->indents.size - 1) {
+        return false;
+    }
+    for (uint32_t i = 1; i < scanner->indents.size; i++) {
+        if ((uint8_t)buffer[2 + delimiter_count + i - 1] != *array_get(&scanner->indents, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool same_state(Scanner *a, Scanner *b) {
+    return a->inside_f_string == b->inside_f_string && a->indents.size == b->indents.size &&
+           a->delimiters.size == b->delimiters.size &&
+           memcmp(a->indents.contents, b->indents.contents, a->indents.size * sizeof(uint16_t)) == 0 &&
+           (a->delimiters.size == 0 ||
+            memcmp(a->delimiters.contents, b->delimiters.contents, a->delimiters.size) == 0);
+}
+
+static void measure(SizeStats *stats, Scanner *scanner, Scanner *scratch) {
+    char buffer[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+
+    unsigned legacy = legacy_serialize(scanner, buffer);
+    stats->legacy_bytes += legacy;
+    stats->legacy_heap += legacy > INLINE_STATE_SIZE ? legacy : 0;
+    stats->legacy_lossy += !legacy_round_trips(scanner, buffer, legacy);
+
+    unsigned length = tree_sitter_xonsh_external_scanner_serialize(scanner, buffer);
+    stats->bytes += length;
+    stats->heap += length > INLINE_STATE_SIZE ? length : 0;
+    tree_sitter_xonsh_external_scanner_deserialize(scratch, buffer, length);
+    stats->lossy += !same_state(scanner, scratch);
+
+    stats->states++;
+}
+
+static void set_indent(Scanner *scanner, uint16_t indent) {
+    while (indent < *array_back(&scanner->indents)) {
+        scanner->indents.size--;
+    }
+    if (indent > *array_back(&scanner->indents)) {
+        inline_array_push(&scanner->indents, indent);
+    }
+}
+
+static bool starts_triple_quote(const char *data, size_t end, size_t position) {
+    return position + 3 <= end && (data[position] == '"' || data[position] == '\'') &&
+           data[position + 1] == data[position] && data[position + 2] == data[position];
+}
+
+/**
+ * Walk `data[start..end)` a line at a time, tracking indentation of code
+ * lines and whether a triple-quoted string is open, and measure the state at
+ * every line.
+ */
+static void measure_input(SizeStats *stats, Scanner *scanner, Scanner *scratch, const char *data, size_t start,
+                          size_t end) {
+    tree_sitter_xonsh_external_scanner_deserialize(scanner, NULL, 0);
+    size_t position = start;
+    while (position < end) {
+        const char *newline = memchr(&data[position], '\n', end - position);
+        size_t line_end = newline ? (size_t)(newline - data) : end;
+
+        uint16_t indent = 0;
+        size_t p = position;
+        for (; p < line_end && (data[p] == ' ' || data[p] == '\t'); p++) {
+            indent += data[p] == '\t' ? 8 : 1;
+        }
+        if (scanner->delimiters.size == 0 && p < line_end && data[p] != '#') {
+            set_indent(scanner, indent);
+        }
+        for (size_t q = p; q < line_end; q++) {
+            if (starts_triple_quote(data, line_end, q)) {
+                if (scanner->delimiters.size == 0) {
+                    Delimiter delimiter = new_delimiter();
+                    set_end_character(&delimiter, data[q]);
+                    set_triple(&delimiter);
+                    inline_array_push(&scanner->delimiters, delimiter);
+                } else {
+                    scanner->delimiters.size = 0;
+                }
+                q += 2;
+            }
+        }
+        measure(stats, scanner, scratch);
+        position = line_end + 1;
+    }
+}
+
+static void report(const char *name, const SizeStats *stats) {
+    double states = stats->states ? (double)stats->states : 1;
+    printf("%-32s %7llu %9.2f %9.2f %9.2f %9.2f %7llu %7llu\n", name, (unsigned long long)stats->states,
+           (double)stats->legacy_bytes / states, (double)stats->bytes / states, (double)stats->legacy_heap / states,
+           (double)stats->heap / states, (unsigned long long)stats->legacy_lossy,
+           (unsigned long long)stats->lossy);
+}
+
+static void add(SizeStats *total, const SizeStats *stats) {
+    total->states += stats->states;
+    total->legacy_bytes += stats->legacy_bytes;
+    total->legacy_heap += stats->legacy_heap;
+    total->legacy_lossy += stats->legacy_lossy;
+    total->bytes += stats->bytes;
+    total->heap += stats->heap;
+    total->lossy += stats->lossy;
+}
+
+/**
+ * Measure the state at each level while nesting `levels` deep, `step`
+ * columns at a time, with `strings` nested f-strings open at the bottom
+ * (alternating quotes when `alternate`).
+ */
+static uint64_t run_synthetic(Scanner *scanner, Scanner *scratch, const char *name, uint32_t levels,
+                              uint16_t step, uint32_t strings, bool alternate) {
+    SizeStats stats = {0};
+    tree_sitter_xonsh_external_scanner_deserialize(scanner, NULL, 0);
+    for (uint32_t i = 0; i < strings; i++) {
+        Delimiter delimiter = new_delimiter();
+        set_end_character(&delimiter, alternate && i % 2 ? '\'' : '"');
+        set_format(&delimiter);
+        inline_array_push(&scanner->delimiters, delimiter);
+        scanner->inside_f_string = true;
+    }
+    for (uint32_t level = 1; level <= levels; level++) {
+        set_indent(scanner, (uint16_t)(level * step));
+        measure(&stats, scanner, scratch);
+    }
+    report(name, &stats);
+    return stats.lossy;
+}
+
+int main(int argc, char **argv) {
+    Scanner *scanner = tree_sitter_xonsh_external_scanner_create();
+    Scanner *scratch = tree_sitter_xonsh_external_scanner_create();
+
+    printf("%-32s %7s %9s %9s %9s %9s %7s %7s\n", "input", "states", "legacy_B", "compact_B", "legacy_hp",
+           "compact_hp", "l_lossy", "lossy");
+
+    SizeStats total = {0};
+    for (int i = 1; i < argc; i++) {
+        SourceText text;
+        if (!source_text_read(argv[i], &text)) {
+            return 1;
+        }
+        SizeStats stats = {0};
+        size_t cursor = 0, start, end;
+        while (corpus_next_input(&text, &cursor, &start, &end)) {
+            measure_input(&stats, scanner, scratch, text.data, start, end);
+        }
+        const char *name = strrchr(argv[i], '/');
+        report(name ? name + 1 : argv[i], &stats);
+        add(&total, &stats);
+        source_text_free(&text);
+    }
+    if (argc > 1) {
+        report("corpus-total", &total);
+    }
+
+    uint64_t lossy = total.lossy;
+    lossy += run_synthetic(scanner, scratch, "deep-4-space", 100, 4, 0, false);
+    lossy += run_synthetic(scanner, scratch, "deep-2-space", 300, 2, 0, false);
+    lossy += run_synthetic(scanner, scratch, "wide-indent", 20, 300, 0, false);
+    lossy += run_synthetic(scanner, scratch, "nested-f-strings", 10, 4, 300, false);
+    lossy += run_synthetic(scanner, scratch, "alternating-f-strings", 10, 4, 300, true);
+
+    tree_sitter_xonsh_external_scanner_destroy(scanner);
+    tree_sitter_xonsh_external_scanner_destroy(scratch);
+    return lossy == 0 ? 0 : 1;
+}
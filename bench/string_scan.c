@@ -0,0 +1,135 @@
+/**
+ * Scanner cost of string bodies and comment runs.
+ *
+ * Builds multi-megabyte triple-quoted strings (plain, f-string, raw and
+ * bytes heredocs) and a long run of comment lines, then drives the external
+ * scanner through them over a BufferLexer the way the parser would: string
+ * content tokens from the scanner, interpolations and escape sequences
+ * stepped over on the grammar's behalf. Reports the time per byte.
+ *
+ *   bench/string_scan [megabytes]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/scanner.c"
+
+#include "generate.h"
+
+#include <time.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+    const char *name;
+    const char *prefix;
+    // printf format of one body line, given the line number
+    const char *line;
+    uint8_t flags;
+} Heredoc;
+
+static const Heredoc heredocs[] = {
+    {"heredoc", "\"\"\"", "line %u of a long document, with 'quotes' and the odd \"double\" one\n", 0},
+    {"f-string-heredoc", "f\"\"\"", "line %u for {user.name} on {host} at {when:%%H:%%M}, with 'quotes'\n", Format},
+    {"raw-heredoc", "r\"\"\"", "line %u: C:\\\\path\\\\to\\\\file and \\\\d+ patterns, 'quoted'\n", Raw},
+    {"bytes-heredoc", "b\"\"\"", "line %u \\x00\\x01 payload bytes and \\n escapes, 'quoted'\n", Bytes},
+};
+
+/**
+ * Scan the string body starting at `position` up to and including its end
+ * quotes. Returns the number of tokens the scanner produced.
+ */
+static uint64_t scan_string(Scanner *scanner, const TextBuffer *source, size_t position, uint8_t flags) {
+    Delimiter delimiter = {0};
+    delimiter.flags = flags;
+    set_end_character(&delimiter, '"');
+    set_triple(&delimiter);
+    inline_array_push(&scanner->delimiters, delimiter);
+
+    bool valid_symbols[PATH_PREFIX + 1] = {false};
+    valid_symbols[STRING_CONTENT] = valid_symbols[STRING_END] = valid_symbols[ESCAPE_INTERPOLATION] = true;
+
+    BufferLexer lexer = {0};
+    uint64_t tokens = 0;
+    while (position < source->length) {
+        buffer_lexer_reset(&lexer, source->data, source->length, position);
+        if (tree_sitter_xonsh_external_scanner_scan(scanner, &lexer.lexer, valid_symbols) &&
+            lexer.marked_end > position) {
+            tokens++;
+            position = lexer.marked_end;
+            if (lexer.lexer.result_symbol == STRING_END) {
+                break;
+            }
+            continue;
+        }
+        // Tokens the grammar lexes itself
+        char c = source->data[position];
+        if (c == '{') {
+            const char *close = memchr(&source->data[position], '}', source->length - position);
+            position = close ? (size_t)(close - source->data) + 1 : source->length;
+        } else {
+            position += c == '\\' ? 2 : 1;
+        }
+    }
+    return tokens;
+}
+
+static void report(const char *name, size_t bytes, uint64_t tokens, uint64_t nanoseconds, unsigned rounds) {
+    double ns_per_byte = (double)nanoseconds / ((double)bytes * rounds);
+    printf("%-20s %10zu %10llu %10.2f %10.1f\n", name, bytes, (unsigned long long)tokens, ns_per_byte,
+           1000.0 / ns_per_byte);
+}
+
+int main(int argc, char **argv) {
+    size_t size = (size_t)(argc > 1 ? strtoul(argv[1], NULL, 10) : 4) * 1024 * 1024;
+    unsigned rounds = 5;
+
+    printf("%-20s %10s %10s %10s %10s\n", "input", "bytes", "tokens", "ns/byte", "MB/s");
+
+    for (size_t h = 0; h < sizeof(heredocs) / sizeof(heredocs[0]); h++) {
+        const Heredoc *heredoc = &heredocs[h];
+        TextBuffer source = {0};
+        text_buffer_printf(&source, "%s\n", heredoc->prefix);
+        size_t body = source.length;
+        for (unsigned line = 0; source.length < size; line++) {
+            text_buffer_printf(&source, heredoc->line, line);
+        }
+        text_buffer_append(&source, "\"\"\"\n", 4);
+
+        Scanner *scanner = tree_sitter_xonsh_external_scanner_create();
+        uint64_t tokens = 0;
+        uint64_t start = now_ns();
+        for (unsigned round = 0; round < rounds; round++) {
+            tokens = scan_string(scanner, &source, body, heredoc->flags);
+        }
+        report(heredoc->name, source.length - body, tokens, now_ns() - start, rounds);
+        tree_sitter_xonsh_external_scanner_destroy(scanner);
+        text_buffer_free(&source);
+    }
+
+    // One scan call at a statement end skips every comment line after it
+    TextBuffer source = {0};
+    text_buffer_append(&source, "x\n", 2);
+    for (unsigned line = 0; source.length < size; line++) {
+        text_buffer_printf(&source, "# comment line %u explaining the next step in some detail\n", line);
+    }
+    text_buffer_append(&source, "y\n", 2);
+
+    Scanner *scanner = tree_sitter_xonsh_external_scanner_create();
+    bool valid_symbols[PATH_PREFIX + 1] = {false};
+    valid_symbols[NEWLINE] = valid_symbols[INDENT] = valid_symbols[DEDENT] = true;
+    BufferLexer lexer = {0};
+    uint64_t start = now_ns();
+    for (unsigned round = 0; round < rounds; round++) {
+        buffer_lexer_reset(&lexer, source.data, source.length, 1);
+        tree_sitter_xonsh_external_scanner_scan(scanner, &lexer.lexer, valid_symbols);
+    }
+    report("comment-run", source.length - 4, 1, now_ns() - start, rounds);
+    tree_sitter_xonsh_external_scanner_destroy(scanner);
+    text_buffer_free(&source);
+    return 0;
+}
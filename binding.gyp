@@ -13,12 +13,18 @@
         "src/parser.c",
       ],
       "variables": {
-        "has_scanner": "<!(node -p \"fs.existsSync('src/scanner.c')\")"
+        "has_scanner": "<!(node -p \"fs.existsSync('src/scanner.c')\")",
+        "has_runtime": "<!(node bindings/node/runtime-flags.js --found)"
       },
       "conditions": [
         ["has_scanner=='true'", {
           "sources+": ["src/scanner.c"],
         }],
+        ["has_runtime=='true'", {
+          "defines": ["TREE_SITTER_XONSH_RUNTIME"],
+          "include_dirs+": ["<!@(node bindings/node/runtime-flags.js --include-dirs)"],
+          "libraries": ["<!@(node bindings/node/runtime-flags.js --libs)"],
+        }],
         ["OS!='win'", {
           "cflags_c": [
             "-std=c11",
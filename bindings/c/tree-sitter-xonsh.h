@@ -1,6 +1,12 @@
 #ifndef TREE_SITTER_XONSH_H_
 #define TREE_SITTER_XONSH_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tree_sitter_xonsh_api.h"
+
 typedef struct TSLanguage TSLanguage;
 
 #ifdef __cplusplus
@@ -1,6 +1,9 @@
 package tree_sitter_xonsh_test
 
 import (
+	"bytes"
+	"os"
+	"path/filepath"
 	"testing"
 
 	tree_sitter "github.com/tree-sitter/go-tree-sitter"
@@ -13,3 +16,101 @@ func TestCanLoadGrammar(t *testing.T) {
 		t.Errorf("Error loading Xonsh grammar")
 	}
 }
+
+func TestParseMany(t *testing.T) {
+	sources := [][]byte{[]byte("ls -la\n"), []byte("x = (1,\n"), []byte("echo hi | grep h\n")}
+	trees := tree_sitter_xonsh.ParseMany(sources, 2)
+	if len(trees) != len(sources) {
+		t.Fatalf("got %d trees for %d sources", len(trees), len(sources))
+	}
+	var pool tree_sitter_xonsh.ParserPool
+	for i, tree := range trees {
+		expected := pool.Parse(sources[i])
+		if tree.RootNode().ToSexp() != expected.RootNode().ToSexp() {
+			t.Errorf("source %d: got %s, want %s", i, tree.RootNode().ToSexp(), expected.RootNode().ToSexp())
+		}
+		expected.Close()
+		tree.Close()
+	}
+	if !trees[1].RootNode().HasError() {
+		t.Errorf("an unclosed parenthesis parsed without errors")
+	}
+	if trees := tree_sitter_xonsh.ParseMany(nil, 0); len(trees) != 0 {
+		t.Errorf("got %d trees for no sources", len(trees))
+	}
+}
+
+// corpusInputs returns the input of every test in test/corpus: the lines
+// between a test's closing `===` line and its `---` line.
+func corpusInputs(b *testing.B) ([][]byte, int64) {
+	paths, err := filepath.Glob(filepath.Join("..", "..", "test", "corpus", "*.txt"))
+	if err != nil || len(paths) == 0 {
+		b.Fatalf("no corpus files: %v", err)
+	}
+	var inputs [][]byte
+	var size int64
+	for _, path := range paths {
+		text, err := os.ReadFile(path)
+		if err != nil {
+			b.Fatal(err)
+		}
+		lines := bytes.SplitAfter(text, []byte("\n"))
+		for i := 0; i+2 < len(lines); i++ {
+			if !bytes.HasPrefix(lines[i], []byte("===")) || !bytes.HasPrefix(lines[i+2], []byte("===")) {
+				continue
+			}
+			end := i + 3
+			for end < len(lines) && !bytes.HasPrefix(lines[end], []byte("---")) {
+				end++
+			}
+			input := bytes.Join(lines[i+3:end], nil)
+			inputs = append(inputs, input)
+			size += int64(len(input))
+			i = end
+		}
+	}
+	return inputs, size
+}
+
+// The benchmarks parse every corpus input once per iteration. allocs/op only
+// counts Go allocations: the parser allocates its trees in C.
+
+func BenchmarkParse(b *testing.B) {
+	inputs, size := corpusInputs(b)
+	var pool tree_sitter_xonsh.ParserPool
+	b.SetBytes(size)
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		for _, input := range inputs {
+			pool.Parse(input).Close()
+		}
+	}
+}
+
+func BenchmarkParseParallel(b *testing.B) {
+	inputs, size := corpusInputs(b)
+	var pool tree_sitter_xonsh.ParserPool
+	b.SetBytes(size)
+	b.ReportAllocs()
+	b.ResetTimer()
+	b.RunParallel(func(pb *testing.PB) {
+		for pb.Next() {
+			for _, input := range inputs {
+				pool.Parse(input).Close()
+			}
+		}
+	})
+}
+
+func BenchmarkParseMany(b *testing.B) {
+	inputs, size := corpusInputs(b)
+	b.SetBytes(size)
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		for _, tree := range tree_sitter_xonsh.ParseMany(inputs, 0) {
+			tree.Close()
+		}
+	}
+}
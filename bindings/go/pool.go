@@ -0,0 +1,82 @@
+package tree_sitter_xonsh
+
+import (
+	"runtime"
+	"sync"
+	"sync/atomic"
+
+	tree_sitter "github.com/tree-sitter/go-tree-sitter"
+)
+
+var language = sync.OnceValue(func() *tree_sitter.Language {
+	return tree_sitter.NewLanguage(Language())
+})
+
+// pooledParser closes its parser when the pool drops it, since sync.Pool
+// discards idle items without telling anyone.
+type pooledParser struct {
+	parser *tree_sitter.Parser
+}
+
+// ParserPool hands xonsh parsers to concurrent goroutines. A parser is used
+// by one goroutine at a time; the pool keeps idle ones for reuse. The zero
+// value is ready to use.
+type ParserPool struct {
+	pool sync.Pool
+}
+
+func (p *ParserPool) get() *pooledParser {
+	if pooled, ok := p.pool.Get().(*pooledParser); ok {
+		return pooled
+	}
+	parser := tree_sitter.NewParser()
+	if err := parser.SetLanguage(language()); err != nil {
+		panic(err)
+	}
+	pooled := &pooledParser{parser}
+	runtime.SetFinalizer(pooled, func(pooled *pooledParser) { pooled.parser.Close() })
+	return pooled
+}
+
+// Parse parses source with a parser from the pool. The caller closes the tree.
+func (p *ParserPool) Parse(source []byte) *tree_sitter.Tree {
+	pooled := p.get()
+	defer p.pool.Put(pooled)
+	return pooled.parser.Parse(source, nil)
+}
+
+// ParseMany parses sources on workers goroutines, runtime.GOMAXPROCS(0) if
+// workers <= 0, and returns their trees in order. Each goroutine takes one
+// parser from the pool and the next source from a shared index. The caller
+// closes the trees.
+func (p *ParserPool) ParseMany(sources [][]byte, workers int) []*tree_sitter.Tree {
+	trees := make([]*tree_sitter.Tree, len(sources))
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	workers = min(workers, len(sources))
+
+	var next atomic.Int64
+	var wg sync.WaitGroup
+	wg.Add(workers)
+	for w := 0; w < workers; w++ {
+		go func() {
+			defer wg.Done()
+			pooled := p.get()
+			defer p.pool.Put(pooled)
+			for i := int(next.Add(1) - 1); i < len(sources); i = int(next.Add(1) - 1) {
+				trees[i] = pooled.parser.Parse(sources[i], nil)
+			}
+		}()
+	}
+	wg.Wait()
+	return trees
+}
+
+var defaultPool ParserPool
+
+// ParseMany parses sources with a process-wide ParserPool. See
+// ParserPool.ParseMany.
+func ParseMany(sources [][]byte, workers int) []*tree_sitter.Tree {
+	return defaultPool.ParseMany(sources, workers)
+}
@@ -0,0 +1,106 @@
+/**
+ * Event-loop latency while many files are parsed.
+ *
+ * Builds --files sources of about --size bytes each from the test/corpus
+ * inputs and parses them all while perf_hooks samples how late the event loop
+ * runs its timers, the way a language server would see it:
+ *
+ *   sync            node-tree-sitter's Parser.parse, one file per macrotask
+ *   parseAsync      every file at once through parseAsync()
+ *   parseManyAsync  one parseManyAsync() call over the pool
+ *
+ * Prints one JSON object per mode, delays in milliseconds:
+ *
+ *   {"mode":"parseAsync","files":1000,"bytes":...,"seconds":...,"delay_p50_ms":...,
+ *    "delay_p99_ms":...,"delay_max_ms":...}
+ *
+ *   node bindings/node/bench_event_loop.js [--files N] [--size BYTES]
+ */
+
+const fs = require("fs");
+const path = require("path");
+const { monitorEventLoopDelay, performance } = require("perf_hooks");
+
+const Parser = require("tree-sitter");
+const language = require(".");
+
+function option(name, fallback) {
+  const index = process.argv.indexOf(name);
+  return index === -1 ? fallback : Number(process.argv[index + 1]);
+}
+
+function corpusInputs() {
+  const directory = path.join(__dirname, "..", "..", "test", "corpus");
+  const inputs = [];
+  for (const file of fs.readdirSync(directory).filter((name) => name.endsWith(".txt")).sort()) {
+    const tests = fs.readFileSync(path.join(directory, file), "utf8").split(/^={3,}\n.*?\n={3,}\n/ms);
+    for (const test of tests.slice(1)) {
+      inputs.push(test.split(/^-{3,}\n/m)[0].replace(/\n+$/, "") + "\n");
+    }
+  }
+  return inputs;
+}
+
+// Consecutive corpus inputs joined into files of at least `size` bytes
+function buildFiles(count, size) {
+  const inputs = corpusInputs();
+  const files = [];
+  let next = 0;
+  while (files.length < count) {
+    let file = "";
+    while (file.length < size) {
+      file += inputs[next++ % inputs.length];
+    }
+    files.push(file);
+  }
+  return files;
+}
+
+const nextMacrotask = () => new Promise((resolve) => setImmediate(resolve));
+
+const modes = {
+  async sync(files) {
+    const parser = new Parser();
+    parser.setLanguage(language);
+    for (const file of files) {
+      parser.parse(file);
+      await nextMacrotask();
+    }
+  },
+  async parseAsync(files) {
+    await Promise.all(files.map((file) => language.parseAsync(file)));
+  },
+  async parseManyAsync(files) {
+    await language.parseManyAsync(files);
+  },
+};
+
+async function main() {
+  if (!language.parseAsync) {
+    console.error("tree-sitter-xonsh was built without the tree-sitter runtime: see runtime-flags.js");
+    process.exit(1);
+  }
+  const files = buildFiles(option("--files", 1000), option("--size", 16384));
+  const bytes = files.reduce((total, file) => total + Buffer.byteLength(file), 0);
+
+  for (const [mode, run] of Object.entries(modes)) {
+    const histogram = monitorEventLoopDelay({ resolution: 1 });
+    histogram.enable();
+    const start = performance.now();
+    await run(files);
+    const seconds = (performance.now() - start) / 1000;
+    histogram.disable();
+    const ms = (nanoseconds) => Number((nanoseconds / 1e6).toFixed(3));
+    console.log(JSON.stringify({
+      mode,
+      files: files.length,
+      bytes,
+      seconds: Number(seconds.toFixed(4)),
+      delay_p50_ms: ms(histogram.percentile(50)),
+      delay_p99_ms: ms(histogram.percentile(99)),
+      delay_max_ms: ms(histogram.max),
+    }));
+  }
+}
+
+main();
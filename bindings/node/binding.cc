@@ -1,18 +1,390 @@
 #include <napi.h>
 
+#ifdef TREE_SITTER_XONSH_RUNTIME
+#include <tree_sitter/api.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#endif
+
+#include "tree_sitter_xonsh_api.h"
+
 typedef struct TSLanguage TSLanguage;
 
 extern "C" TSLanguage *tree_sitter_xonsh();
 
+static const char *const LINE_KIND_NAMES[] = {"python", "subprocess", "subprocess_macro", "block_macro"};
+
 // "tree-sitter", "language" hashed with BLAKE2
 const napi_type_tag LANGUAGE_TYPE_TAG = {
     0x8AF2E5212AD58ABF, 0xD5006CAD83ABBA16
 };
 
+Napi::Value RegisterCommands(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        throw Napi::TypeError::New(env, "registerCommands expects an array of strings");
+    }
+    Napi::Array names = info[0].As<Napi::Array>();
+    uint32_t registered = 0;
+    for (uint32_t i = 0; i < names.Length(); i++) {
+        Napi::Value name = names[i];
+        if (!name.IsString()) {
+            throw Napi::TypeError::New(env, "registerCommands expects an array of strings");
+        }
+        std::string utf8 = name.As<Napi::String>().Utf8Value();
+        if (tree_sitter_xonsh_register_command(utf8.data(), utf8.size())) {
+            registered++;
+        }
+    }
+    return Napi::Number::New(env, registered);
+}
+
+Napi::Value ClearCommands(const Napi::CallbackInfo &info) {
+    tree_sitter_xonsh_clear_commands();
+    return info.Env().Undefined();
+}
+
+Napi::Value RegisteredCommandCount(const Napi::CallbackInfo &info) {
+    return Napi::Number::New(info.Env(), static_cast<double>(tree_sitter_xonsh_registered_command_count()));
+}
+
+Napi::Value ClassifyLine(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        throw Napi::TypeError::New(env, "classifyLine expects a string");
+    }
+    std::string utf8 = info[0].As<Napi::String>().Utf8Value();
+    size_t macro_end;
+    int kind = tree_sitter_xonsh_classify_line(utf8.data(), utf8.size(), &macro_end);
+
+    // JavaScript string indices count UTF-16 code units, not UTF-8 bytes
+    size_t units = 0;
+    for (size_t i = 0; i < macro_end; i++) {
+        unsigned char byte = static_cast<unsigned char>(utf8[i]);
+        if ((byte & 0xC0) != 0x80) {
+            units += byte >= 0xF0 ? 2 : 1;
+        }
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result["kind"] = Napi::String::New(env, LINE_KIND_NAMES[kind]);
+    result["macroEnd"] = Napi::Number::New(env, static_cast<double>(units));
+    return result;
+}
+
+#ifdef TREE_SITTER_XONSH_RUNTIME
+// Arbitrary: only this addon makes the externals Tree is constructed from
+const napi_type_tag TREE_TYPE_TAG = {
+    0x3C5E0A7B91D24F68, 0xA1F3B2C49D07E516
+};
+
+/**
+ * A parsed tree handed to JavaScript by parseAsync(). Owns its TSTree, which
+ * the garbage collector frees. Offsets are UTF-8 byte offsets of the source.
+ */
+class Tree : public Napi::ObjectWrap<Tree> {
+  public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "Tree", {
+            InstanceAccessor<&Tree::HasError>("hasError"),
+            InstanceAccessor<&Tree::NodeCount>("nodeCount"),
+            InstanceMethod<&Tree::Edit>("edit"),
+            InstanceMethod<&Tree::ToString>("toString"),
+        });
+    }
+
+    static Napi::Object New(Napi::Env env, TSTree *tree) {
+        auto external = Napi::External<TSTree>::New(env, tree);
+        external.TypeTag(&TREE_TYPE_TAG);
+        return env.GetInstanceData<Napi::FunctionReference>()->New({external});
+    }
+
+    // The Tree wrapped by `value`, or nullptr if it is not one
+    static Tree *From(Napi::Value value) {
+        Napi::FunctionReference *constructor = value.Env().GetInstanceData<Napi::FunctionReference>();
+        if (!value.IsObject() || !value.As<Napi::Object>().InstanceOf(constructor->Value())) {
+            return nullptr;
+        }
+        return Unwrap(value.As<Napi::Object>());
+    }
+
+    Tree(const Napi::CallbackInfo &info) : Napi::ObjectWrap<Tree>(info), tree_(nullptr) {
+        if (info.Length() != 1 || !info[0].IsExternal() ||
+            !info[0].As<Napi::External<TSTree>>().CheckTypeTag(&TREE_TYPE_TAG)) {
+            throw Napi::TypeError::New(info.Env(), "trees are made by parseAsync and parseManyAsync");
+        }
+        tree_ = info[0].As<Napi::External<TSTree>>().Data();
+    }
+
+    ~Tree() { ts_tree_delete(tree_); }
+
+    TSTree *tree() const { return tree_; }
+
+  private:
+    Napi::Value HasError(const Napi::CallbackInfo &info) {
+        return Napi::Boolean::New(info.Env(), ts_node_has_error(ts_tree_root_node(tree_)));
+    }
+
+    Napi::Value NodeCount(const Napi::CallbackInfo &info) {
+        return Napi::Number::New(info.Env(), ts_node_descendant_count(ts_tree_root_node(tree_)));
+    }
+
+    Napi::Value ToString(const Napi::CallbackInfo &info) {
+        char *sexp = ts_node_string(ts_tree_root_node(tree_));
+        Napi::String result = Napi::String::New(info.Env(), sexp);
+        free(sexp);
+        return result;
+    }
+
+    // Same shape as node-tree-sitter's Tree.edit(), in UTF-8 bytes
+    Napi::Value Edit(const Napi::CallbackInfo &info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsObject()) {
+            throw Napi::TypeError::New(env, "edit expects an edit object");
+        }
+        Napi::Object edit = info[0].As<Napi::Object>();
+        auto index = [&](const char *key) {
+            Napi::Value value = edit.Get(key);
+            if (!value.IsNumber()) {
+                throw Napi::TypeError::New(env, std::string("edit needs a numeric ") + key);
+            }
+            return value.As<Napi::Number>().Uint32Value();
+        };
+        auto point = [&](const char *key) {
+            Napi::Value value = edit.Get(key);
+            if (!value.IsObject()) {
+                throw Napi::TypeError::New(env, std::string("edit needs a {row, column} ") + key);
+            }
+            Napi::Object object = value.As<Napi::Object>();
+            return TSPoint{object.Get("row").ToNumber().Uint32Value(), object.Get("column").ToNumber().Uint32Value()};
+        };
+        TSInputEdit input_edit;
+        input_edit.start_byte = index("startIndex");
+        input_edit.old_end_byte = index("oldEndIndex");
+        input_edit.new_end_byte = index("newEndIndex");
+        input_edit.start_point = point("startPosition");
+        input_edit.old_end_point = point("oldEndPosition");
+        input_edit.new_end_point = point("newEndPosition");
+        ts_tree_edit(tree_, &input_edit);
+        return info.This();
+    }
+
+    TSTree *tree_;
+};
+
+/**
+ * Sources parsed one ParseWorker each. At most `in_flight` of them are
+ * queued on the libuv pool at a time: each finished worker queues the next
+ * source from the main thread, so other pool users (fs, dns, zlib) get a
+ * thread in between instead of waiting behind the whole batch. The last
+ * worker to finish settles the promise.
+ */
+struct ParseBatch {
+    ParseBatch(Napi::Env env, bool single)
+        : deferred(Napi::Promise::Deferred::New(env)), single(single), failed(false), incompatible(false),
+          queued(0), finished(0) {}
+
+    ~ParseBatch() {
+        for (TSTree *tree : old_trees) {
+            if (tree != nullptr) {
+                ts_tree_delete(tree);
+            }
+        }
+        for (TSTree *tree : trees) {
+            if (tree != nullptr) {
+                ts_tree_delete(tree);
+            }
+        }
+    }
+
+    Napi::Promise::Deferred deferred;
+    bool single;  // resolve with the one tree, not an array
+    std::vector<std::string> sources;
+    std::vector<TSTree *> old_trees;  // copies, so JavaScript can keep editing its own
+    std::vector<TSTree *> trees;
+    std::atomic<bool> failed;
+    std::atomic<bool> incompatible;  // the runtime's ABI range misses this parser's version
+    size_t queued;    // only touched on the main thread
+    size_t finished;  // only touched on the main thread
+};
+
+/**
+ * The calling pool thread's parser, made on its first parse and deleted when
+ * the thread exits, or nullptr if the runtime cannot load this language.
+ */
+static TSParser *ThreadParser() {
+    struct Holder {
+        Holder() : parser(ts_parser_new()), compatible(ts_parser_set_language(parser, tree_sitter_xonsh())) {}
+        ~Holder() { ts_parser_delete(parser); }
+        TSParser *parser;
+        bool compatible;
+    };
+    thread_local Holder holder;
+    return holder.compatible ? holder.parser : nullptr;
+}
+
+class ParseWorker : public Napi::AsyncWorker {
+  public:
+    ParseWorker(Napi::Env env, std::shared_ptr<ParseBatch> batch, size_t index)
+        : Napi::AsyncWorker(env, "tree-sitter-xonsh.parse"), batch_(std::move(batch)), index_(index) {}
+
+    // Queues the batch's next source; main thread only
+    static void QueueNext(Napi::Env env, const std::shared_ptr<ParseBatch> &batch) {
+        (new ParseWorker(env, batch, batch->queued++))->Queue();
+    }
+
+    // Runs on a libuv pool thread: touches nothing but its source and tree
+    void Execute() override {
+        if (batch_->failed) {
+            return;
+        }
+        TSParser *parser = ThreadParser();
+        if (parser == nullptr) {
+            batch_->incompatible = true;
+            batch_->failed = true;
+            return;
+        }
+        const std::string &source = batch_->sources[index_];
+        batch_->trees[index_] = ts_parser_parse_string(parser, batch_->old_trees[index_], source.data(),
+                                                       static_cast<uint32_t>(source.size()));
+        if (batch_->trees[index_] == nullptr) {
+            batch_->failed = true;
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        batch_->finished++;
+        if (!batch_->failed && batch_->queued < batch_->sources.size()) {
+            QueueNext(env, batch_);
+            return;
+        }
+        if (batch_->finished < batch_->queued) {
+            return;
+        }
+        if (batch_->incompatible) {
+            std::string message =
+                "the tree-sitter runtime tree-sitter-xonsh was built against loads language versions " +
+                std::to_string(TREE_SITTER_MIN_COMPATIBLE_LANGUAGE_VERSION) + " to " +
+                std::to_string(TREE_SITTER_LANGUAGE_VERSION) + ", but this parser is version " +
+                std::to_string(ts_language_version(tree_sitter_xonsh())) + "; rebuild it against a matching runtime";
+            batch_->deferred.Reject(Napi::Error::New(env, message).Value());
+            return;
+        }
+        if (batch_->failed) {
+            batch_->deferred.Reject(Napi::Error::New(env, "tree-sitter-xonsh could not parse a source").Value());
+            return;
+        }
+        Napi::Array trees = Napi::Array::New(env, batch_->trees.size());
+        for (size_t i = 0; i < batch_->trees.size(); i++) {
+            trees[static_cast<uint32_t>(i)] = Tree::New(env, batch_->trees[i]);
+            batch_->trees[i] = nullptr;
+        }
+        batch_->deferred.Resolve(batch_->single ? trees.Get(0u) : Napi::Value(trees));
+    }
+
+  private:
+    std::shared_ptr<ParseBatch> batch_;
+    size_t index_;
+};
+
+// Copies a string (as UTF-8) or a Buffer, which the caller may change while it is parsed
+static bool ReadSource(Napi::Value value, std::string *source) {
+    if (value.IsString()) {
+        *source = value.As<Napi::String>().Utf8Value();
+    } else if (value.IsBuffer()) {
+        Napi::Buffer<char> buffer = value.As<Napi::Buffer<char>>();
+        source->assign(buffer.Data(), buffer.Length());
+    } else {
+        return false;
+    }
+    return source->size() <= UINT32_MAX;
+}
+
+static Napi::Value StartBatch(Napi::Env env, std::shared_ptr<ParseBatch> batch, size_t in_flight) {
+    batch->trees.assign(batch->sources.size(), nullptr);
+    batch->old_trees.resize(batch->sources.size(), nullptr);
+    if (batch->sources.empty()) {
+        batch->deferred.Resolve(Napi::Array::New(env));
+        return batch->deferred.Promise();
+    }
+    if (in_flight > batch->sources.size()) {
+        in_flight = batch->sources.size();
+    }
+    for (size_t i = 0; i < in_flight; i++) {
+        ParseWorker::QueueNext(env, batch);
+    }
+    return batch->deferred.Promise();
+}
+
+Napi::Value ParseAsync(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto batch = std::make_shared<ParseBatch>(env, true);
+    batch->sources.resize(1);
+    if (info.Length() < 1 || !ReadSource(info[0], &batch->sources[0])) {
+        throw Napi::TypeError::New(env, "parseAsync expects a string or Buffer of at most 4 GiB");
+    }
+    batch->old_trees.push_back(nullptr);
+    if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsNull()) {
+        Tree *old_tree = Tree::From(info[1]);
+        if (old_tree == nullptr) {
+            throw Napi::TypeError::New(env, "parseAsync expects a tree from parseAsync as its old tree");
+        }
+        batch->old_trees[0] = ts_tree_copy(old_tree->tree());
+    }
+    return StartBatch(env, batch, 1);
+}
+
+Napi::Value ParseManyAsync(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        throw Napi::TypeError::New(env, "parseManyAsync expects an array of strings or Buffers");
+    }
+    Napi::Array sources = info[0].As<Napi::Array>();
+    auto batch = std::make_shared<ParseBatch>(env, false);
+    batch->sources.resize(sources.Length());
+    for (uint32_t i = 0; i < sources.Length(); i++) {
+        if (!ReadSource(sources[i], &batch->sources[i])) {
+            throw Napi::TypeError::New(env, "parseManyAsync expects an array of strings or Buffers of at most 4 GiB");
+        }
+    }
+
+    // libuv runs UV_THREADPOOL_SIZE (4 by default) workers at a time; keep
+    // one of them free for the rest of the process unless told otherwise
+    size_t pool_size = 4;
+    if (const char *value = std::getenv("UV_THREADPOOL_SIZE")) {
+        pool_size = std::strtoul(value, nullptr, 10);
+    }
+    size_t workers = pool_size > 1 ? pool_size - 1 : 1;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Value option = info[1].As<Napi::Object>().Get("workers");
+        if (option.IsNumber()) {
+            workers = option.As<Napi::Number>().Uint32Value();
+        }
+    }
+    return StartBatch(env, batch, workers > 0 ? workers : 1);
+}
+#endif
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     auto language = Napi::External<TSLanguage>::New(env, tree_sitter_xonsh());
     language.TypeTag(&LANGUAGE_TYPE_TAG);
     exports["language"] = language;
+    exports["registerCommands"] = Napi::Function::New(env, RegisterCommands, "registerCommands");
+    exports["clearCommands"] = Napi::Function::New(env, ClearCommands, "clearCommands");
+    exports["registeredCommandCount"] =
+        Napi::Function::New(env, RegisteredCommandCount, "registeredCommandCount");
+    exports["classifyLine"] = Napi::Function::New(env, ClassifyLine, "classifyLine");
+#ifdef TREE_SITTER_XONSH_RUNTIME
+    env.SetInstanceData(new Napi::FunctionReference(Napi::Persistent(Tree::Define(env))));
+    exports["parseAsync"] = Napi::Function::New(env, ParseAsync, "parseAsync");
+    exports["parseManyAsync"] = Napi::Function::New(env, ParseManyAsync, "parseManyAsync");
+#endif
     return exports;
 }
 
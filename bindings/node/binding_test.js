@@ -3,7 +3,87 @@ const { test } = require("node:test");
 
 const Parser = require("tree-sitter");
 
+// CI builds against the runtime and sets this, so a build without it fails instead of skipping
+const noRuntime = !require(".").parseAsync && process.env.TREE_SITTER_XONSH_REQUIRE_RUNTIME !== "1" &&
+  "built without the tree-sitter runtime";
+
 test("can load grammar", () => {
   const parser = new Parser();
   assert.doesNotThrow(() => parser.setLanguage(require(".")));
 });
+
+test("registered command starts a bare subprocess", () => {
+  const language = require(".");
+  try {
+    assert.strictEqual(language.registerCommands(["myregisteredapp", "not-an-identifier"]), 1);
+    const parser = new Parser();
+    parser.setLanguage(language);
+    const tree = parser.parse("myregisteredapp\n");
+    assert.strictEqual(tree.rootNode.child(0).type, "bare_subprocess");
+  } finally {
+    language.clearCommands();
+  }
+});
+
+test("classifies lines without parsing", () => {
+  const language = require(".");
+  assert.deepStrictEqual(language.classifyLine("ls -la /tmp"), { kind: "subprocess", macroEnd: 0 });
+  assert.deepStrictEqual(language.classifyLine("x = 1"), { kind: "python", macroEnd: 0 });
+  assert.deepStrictEqual(language.classifyLine("with! Context():"), { kind: "block_macro", macroEnd: 5 });
+  assert.deepStrictEqual(language.classifyLine("  echo! héllo"), { kind: "subprocess_macro", macroEnd: 8 });
+});
+
+test("parses on the thread pool", { skip: noRuntime }, async () => {
+  const language = require(".");
+  assert.ok(language.parseAsync, "built without the tree-sitter runtime");
+  const parser = new Parser();
+  parser.setLanguage(language);
+
+  const source = "ls -la\nx = 1\n";
+  const tree = await language.parseAsync(source);
+  assert.strictEqual(tree.toString(), parser.parse(source).rootNode.toString());
+  assert.strictEqual(tree.hasError, false);
+  assert.ok(tree.nodeCount > 1);
+
+  tree.edit({
+    startIndex: 7, oldEndIndex: 8, newEndIndex: 8,
+    startPosition: { row: 1, column: 0 }, oldEndPosition: { row: 1, column: 1 }, newEndPosition: { row: 1, column: 1 },
+  });
+  const edited = "ls -la\ny = 1\n";
+  assert.strictEqual((await language.parseAsync(Buffer.from(edited), tree)).toString(),
+    parser.parse(edited).rootNode.toString());
+
+  const sources = ["echo hi\n", "x = (1,\n", "if x:\n    ls\n"];
+  const trees = await language.parseManyAsync(sources, { workers: 2 });
+  assert.deepStrictEqual(trees.map((each) => each.toString()),
+    sources.map((each) => parser.parse(each).rootNode.toString()));
+  assert.deepStrictEqual(trees.map((each) => each.hasError),
+    sources.map((each) => parser.parse(each).rootNode.hasError));
+  assert.strictEqual(trees[1].hasError, true);
+  assert.deepStrictEqual(await language.parseManyAsync([]), []);
+  assert.throws(() => language.parseAsync(1), TypeError);
+});
+
+test("registers commands while a batch parses", { skip: noRuntime }, async () => {
+  const language = require(".");
+  assert.ok(language.parseManyAsync, "built without the tree-sitter runtime");
+  const names = Array.from({ length: 500 }, (_, i) => `racecmd${i}`);
+  const sources = Array.from({ length: 64 }, (_, i) => `racecmd${i % 8} --flag\nx = ${i}\n`.repeat(200));
+  try {
+    // The pool looks names up while the table is cleared and grown through several rehashes
+    const parsing = language.parseManyAsync(sources, { workers: 4 });
+    for (let round = 0; round < 20; round++) {
+      language.clearCommands();
+      language.registerCommands(names);
+    }
+    assert.strictEqual((await parsing).length, sources.length);
+
+    const parser = new Parser();
+    parser.setLanguage(language);
+    const trees = await language.parseManyAsync(sources.slice(0, 8));
+    assert.deepStrictEqual(trees.map((each) => each.toString()),
+      sources.slice(0, 8).map((each) => parser.parse(each).rootNode.toString()));
+  } finally {
+    language.clearCommands();
+  }
+});
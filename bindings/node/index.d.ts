@@ -18,9 +18,62 @@ type NodeInfo =
       children: ChildNode[];
     });
 
+/**
+ * A tree parsed off the main thread by `parseAsync` or `parseManyAsync`.
+ * Indexes and columns count UTF-8 bytes of the source.
+ */
+type Tree = {
+  readonly hasError: boolean;
+  /** Number of nodes in the tree, the root included. */
+  readonly nodeCount: number;
+  /** Tell the tree about an edit before passing it to `parseAsync` again. */
+  edit(edit: {
+    startIndex: number;
+    oldEndIndex: number;
+    newEndIndex: number;
+    startPosition: { row: number; column: number };
+    oldEndPosition: { row: number; column: number };
+    newEndPosition: { row: number; column: number };
+  }): Tree;
+  /** The tree as an S-expression. */
+  toString(): string;
+};
+
 type Language = {
   language: unknown;
   nodeTypeInfo: NodeInfo[];
+  /**
+   * Register extra command names that start bare subprocesses. Returns how
+   * many names were accepted (identifier-shaped, at most 63 bytes). The
+   * registry is process-wide, and may change while parses run on the thread
+   * pool.
+   */
+  registerCommands(names: string[]): number;
+  /** Forget every command name registered with `registerCommands`. */
+  clearCommands(): void;
+  /** Number of distinct command names currently registered. */
+  registeredCommandCount(): number;
+  /**
+   * Classify the statement a line starts without parsing it. `macroEnd` is
+   * the index where a macro's argument text starts, 0 for other kinds.
+   */
+  classifyLine(line: string): {
+    kind: "python" | "subprocess" | "subprocess_macro" | "block_macro";
+    macroEnd: number;
+  };
+  /**
+   * Parse on the libuv thread pool, reusing `oldTree` (already edited) if
+   * given. Only there when the addon was built against the tree-sitter
+   * runtime (pkg-config, or TS_RUNTIME_CFLAGS/TS_RUNTIME_LIBS).
+   */
+  parseAsync?(source: string | Buffer, oldTree?: Tree | null): Promise<Tree>;
+  /**
+   * Parse many sources on the libuv thread pool, one pool task per source
+   * with at most `workers` queued at a time (by default one less than
+   * UV_THREADPOOL_SIZE, which is 4 unless set). Resolves with the trees in
+   * order. Same build requirement as `parseAsync`.
+   */
+  parseManyAsync?(sources: (string | Buffer)[], options?: { workers?: number }): Promise<Tree[]>;
 };
 
 declare const language: Language;
@@ -0,0 +1,40 @@
+/**
+ * Prints the tree-sitter runtime flags for binding.gyp, which needs them for
+ * parseAsync(): TS_RUNTIME_CFLAGS/TS_RUNTIME_LIBS if set, as for `make bench`,
+ * else pkg-config. Without the runtime the addon builds without parseAsync().
+ *
+ *   node bindings/node/runtime-flags.js --found|--include-dirs|--libs
+ */
+
+const { execFileSync } = require("child_process");
+
+function flags(pkgConfigOption, variable) {
+  if (process.env.TS_RUNTIME_LIBS !== undefined) {
+    return process.env[variable] || "";
+  }
+  try {
+    return execFileSync("pkg-config", [pkgConfigOption, "tree-sitter"], {
+      encoding: "utf8",
+      stdio: ["ignore", "pipe", "ignore"],
+    });
+  } catch (_) {
+    return null;
+  }
+}
+
+const words = (text) => (text || "").trim().split(/\s+/).filter(Boolean);
+
+switch (process.argv[2]) {
+  case "--found":
+    console.log(flags("--libs", "TS_RUNTIME_LIBS") === null ? "false" : "true");
+    break;
+  case "--include-dirs":
+    console.log(words(flags("--cflags", "TS_RUNTIME_CFLAGS"))
+      .filter((flag) => flag.startsWith("-I"))
+      .map((flag) => flag.slice(2))
+      .join(" "));
+    break;
+  case "--libs":
+    console.log(words(flags("--libs", "TS_RUNTIME_LIBS")).join(" "));
+    break;
+}
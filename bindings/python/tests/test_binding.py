@@ -1,12 +1,95 @@
+from mmap import mmap
+from os import environ
+from tempfile import TemporaryFile
 from unittest import TestCase
 
 from tree_sitter import Language, Parser
 import tree_sitter_xonsh
 
 
+def _descendants(node):
+    yield node
+    for child in node.children:
+        yield from _descendants(child)
+
+
+# CI builds against the runtime and sets this, so a build without it fails
+# the runtime tests instead of skipping them
+REQUIRE_RUNTIME = environ.get("TREE_SITTER_XONSH_REQUIRE_RUNTIME") == "1"
+
+
 class TestLanguage(TestCase):
     def test_can_load_grammar(self):
         try:
             Parser(Language(tree_sitter_xonsh.language()))
         except Exception:
             self.fail("Error loading Xonsh grammar")
+
+    def test_registered_command_starts_bare_subprocess(self):
+        self.addCleanup(tree_sitter_xonsh.clear_commands)
+        self.assertEqual(tree_sitter_xonsh.register_commands(["myregisteredapp", "not-an-identifier"]), 1)
+        parser = Parser(Language(tree_sitter_xonsh.language()))
+        tree = parser.parse(b"myregisteredapp\n")
+        self.assertEqual(tree.root_node.children[0].type, "bare_subprocess")
+
+    def test_classify_line(self):
+        self.assertEqual(tree_sitter_xonsh.classify_line("ls -la /tmp"), ("subprocess", 0))
+        self.assertEqual(tree_sitter_xonsh.classify_line(b"x = 1"), ("python", 0))
+        self.assertEqual(tree_sitter_xonsh.classify_line("with! Context():"), ("block_macro", 5))
+        self.assertEqual(tree_sitter_xonsh.classify_line("  echo! héllo"), ("subprocess_macro", 8))
+
+    def test_queries_compile_once(self):
+        for accessor in (
+            tree_sitter_xonsh.highlights_query,
+            tree_sitter_xonsh.injections_query,
+            tree_sitter_xonsh.locals_query,
+        ):
+            self.assertIs(accessor(), accessor())
+        self.assertGreater(tree_sitter_xonsh.highlights_query().pattern_count, 0)
+        self.assertIn("bare_subprocess", tree_sitter_xonsh.HIGHLIGHTS_QUERY)
+
+    def test_parse_many(self):
+        sources = ["ls -la\n", b"x = (1,\n", "echo hi | grep h\n" * 3]
+        try:
+            results = tree_sitter_xonsh.parse_many(sources, 2, node_types=["bare_subprocess"], sexp=True)
+        except RuntimeError:
+            if REQUIRE_RUNTIME:
+                raise
+            self.skipTest("built without the tree-sitter runtime")
+        self.assertEqual(len(results), 3)
+        parser = Parser(Language(tree_sitter_xonsh.language()))
+        for source, (has_error, node_count, sexp, ranges) in zip(sources, results):
+            data = source.encode() if isinstance(source, str) else source
+            root = parser.parse(data).root_node
+            self.assertEqual(has_error, root.has_error)
+            self.assertEqual(node_count, root.descendant_count)
+            self.assertEqual(sexp, str(root))
+            self.assertEqual(ranges, [
+                (node.type, node.start_byte, node.end_byte)
+                for node in _descendants(root) if node.type == "bare_subprocess"
+            ])
+        self.assertTrue(results[1][0])
+        self.assertEqual(len(results[0][3]), 1)
+        self.assertEqual(len(results[2][3]), 3)
+        self.assertEqual(tree_sitter_xonsh.parse_many([]), [])
+        self.assertEqual(tree_sitter_xonsh.parse_many(["x\n"])[0][2:], (None, None))
+
+    def test_parse_buffer(self):
+        source = b"ls -la\nx = 1\n"
+        try:
+            expected = tree_sitter_xonsh.parse_buffer(source, node_types=["bare_subprocess"], sexp=True)
+        except RuntimeError:
+            if REQUIRE_RUNTIME:
+                raise
+            self.skipTest("built without the tree-sitter runtime")
+        with TemporaryFile() as file:
+            file.write(source)
+            file.flush()
+            with mmap(file.fileno(), 0) as mapped:
+                for buffer in (mapped, memoryview(source), bytearray(source), source.decode()):
+                    self.assertEqual(
+                        tree_sitter_xonsh.parse_buffer(buffer, node_types=["bare_subprocess"], sexp=True), expected
+                    )
+        self.assertEqual(tree_sitter_xonsh.parse_many([bytearray(source)])[0][:2], expected[:2])
+        with self.assertRaises(BufferError):
+            tree_sitter_xonsh.parse_buffer(memoryview(source)[::2])
@@ -0,0 +1,66 @@
+from unittest import TestCase
+
+from tree_sitter import Language, Parser
+import tree_sitter_xonsh
+
+# Single-line statements, repeated up to the requested length
+LINES = {
+    "assignment": (b"x = ", b"a + "),
+    "call": (b"f(", b"a, "),
+    "flags": (b"ls ", b"-la "),
+    "pipeline": (b"cat file ", b"| grep foo "),
+    "bare_words": (b"echo ", b"word "),
+    "string": (b"s = 'x", b"abcd"),
+}
+
+SIZES = (1024, 8 * 1024, 64 * 1024)
+
+
+def make_line(head, body, size):
+    repeat = (size - len(head)) // len(body)
+    tail = b"'" if head.endswith(b"'x") else b""
+    if head.endswith(b"("):
+        tail = b"a)"
+    elif head == b"x = ":
+        tail = b"a"
+    return head + body * repeat + tail + b"\n"
+
+
+class TestLineLengthScaling(TestCase):
+    def setUp(self):
+        self.parser = Parser(Language(tree_sitter_xonsh.language()))
+
+    def reads_per_byte(self, source):
+        # Hand the parser one byte per read, so every byte the lexer and the
+        # scanner visit, and every revisit after a scanner's lookahead, is a
+        # read. Unlike time, the count is the same on every run; the timing
+        # lives in scripts/bench-python-line-scaling.py.
+        reads = 0
+
+        def read(byte, _point):
+            nonlocal reads
+            reads += 1
+            return source[byte:byte + 1]
+
+        self.parser.parse(read)
+        return reads / len(source)
+
+    def test_bytes_read_per_byte_stays_flat(self):
+        for name, (head, body) in LINES.items():
+            with self.subTest(line=name):
+                costs = [self.reads_per_byte(make_line(head, body, size)) for size in SIZES]
+                # Lookahead that grows with the line shows up as reads per
+                # byte growing with it; detection reads a statement once
+                self.assertLessEqual(costs[-1], costs[0] * 1.25, f"{name}: {costs}")
+
+    def test_long_lines_keep_their_kind(self):
+        cases = {
+            "assignment": "expression_statement",
+            "flags": "bare_subprocess",
+            "pipeline": "bare_subprocess",
+        }
+        for name, node_type in cases.items():
+            with self.subTest(line=name):
+                head, body = LINES[name]
+                tree = self.parser.parse(make_line(head, body, SIZES[-1]))
+                self.assertEqual(tree.root_node.children[0].type, node_type)
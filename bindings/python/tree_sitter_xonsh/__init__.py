@@ -1,8 +1,17 @@
 """Xonsh grammar for tree-sitter"""
 
 from importlib.resources import files as _files
+from threading import Lock as _Lock
 
-from ._binding import language
+from ._binding import (
+    classify_line,
+    clear_commands,
+    language,
+    parse_buffer,
+    parse_many,
+    register_commands,
+    registered_command_count,
+)
 
 
 def _get_query(name, file):
@@ -12,25 +21,68 @@ def _get_query(name, file):
 
 
 def __getattr__(name):
-    # NOTE: uncomment these to include any queries that this grammar contains:
-
-    # if name == "HIGHLIGHTS_QUERY":
-    #     return _get_query("HIGHLIGHTS_QUERY", "highlights.scm")
-    # if name == "INJECTIONS_QUERY":
-    #     return _get_query("INJECTIONS_QUERY", "injections.scm")
-    # if name == "LOCALS_QUERY":
-    #     return _get_query("LOCALS_QUERY", "locals.scm")
+    if name == "HIGHLIGHTS_QUERY":
+        return _get_query("HIGHLIGHTS_QUERY", "highlights.scm")
+    if name == "INJECTIONS_QUERY":
+        return _get_query("INJECTIONS_QUERY", "injections.scm")
+    if name == "LOCALS_QUERY":
+        return _get_query("LOCALS_QUERY", "locals.scm")
+
+    # NOTE: uncomment this to include a tags query if this grammar gets one:
+
     # if name == "TAGS_QUERY":
     #     return _get_query("TAGS_QUERY", "tags.scm")
 
     raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
 
 
+_compiled = {}
+_compiled_lock = _Lock()
+
+
+def _compiled_query(name):
+    # Compiled once per process: the highlights query takes milliseconds
+    query = _compiled.get(name)
+    if query is None:
+        with _compiled_lock:
+            query = _compiled.get(name)
+            if query is None:
+                from tree_sitter import Language, Query
+
+                query = Query(Language(language()), __getattr__(name))
+                _compiled[name] = query
+    return query
+
+
+def highlights_query():
+    """HIGHLIGHTS_QUERY as a tree_sitter.Query, compiled on first use and shared by the process."""
+    return _compiled_query("HIGHLIGHTS_QUERY")
+
+
+def injections_query():
+    """INJECTIONS_QUERY as a tree_sitter.Query, compiled once per process."""
+    return _compiled_query("INJECTIONS_QUERY")
+
+
+def locals_query():
+    """LOCALS_QUERY as a tree_sitter.Query, compiled once per process."""
+    return _compiled_query("LOCALS_QUERY")
+
+
 __all__ = [
     "language",
-    # "HIGHLIGHTS_QUERY",
-    # "INJECTIONS_QUERY",
-    # "LOCALS_QUERY",
+    "register_commands",
+    "clear_commands",
+    "registered_command_count",
+    "classify_line",
+    "parse_many",
+    "parse_buffer",
+    "highlights_query",
+    "injections_query",
+    "locals_query",
+    "HIGHLIGHTS_QUERY",
+    "INJECTIONS_QUERY",
+    "LOCALS_QUERY",
     # "TAGS_QUERY",
 ]
 
@@ -1,10 +1,40 @@
-from typing import Final
+from mmap import mmap
+from typing import Final, Iterable, Literal, Sequence, Union
 
-# NOTE: uncomment these to include any queries that this grammar contains:
+from tree_sitter import Query
+
+HIGHLIGHTS_QUERY: Final[str]
+INJECTIONS_QUERY: Final[str]
+LOCALS_QUERY: Final[str]
+
+# NOTE: uncomment this to include a tags query if this grammar gets one:
 
-# HIGHLIGHTS_QUERY: Final[str]
-# INJECTIONS_QUERY: Final[str]
-# LOCALS_QUERY: Final[str]
 # TAGS_QUERY: Final[str]
 
+def highlights_query() -> Query: ...
+def injections_query() -> Query: ...
+def locals_query() -> Query: ...
+
 def language() -> object: ...
+def register_commands(names: Iterable[str], /) -> int: ...
+def clear_commands() -> None: ...
+def registered_command_count() -> int: ...
+def classify_line(
+    line: str | bytes, /
+) -> tuple[Literal["python", "subprocess", "subprocess_macro", "block_macro"], int]: ...
+_Source = Union[str, bytes, bytearray, memoryview, mmap]
+_ParseResult = tuple[bool, int, str | None, list[tuple[str, int, int]] | None]
+
+def parse_many(
+    sources: Sequence[_Source],
+    workers: int = 0,
+    *,
+    node_types: Iterable[str] | None = None,
+    sexp: bool = False,
+) -> list[_ParseResult]: ...
+def parse_buffer(
+    source: _Source,
+    *,
+    node_types: Iterable[str] | None = None,
+    sexp: bool = False,
+) -> _ParseResult: ...
@@ -1,13 +1,584 @@
 #include <Python.h>
+#include <pythread.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef TREE_SITTER_XONSH_RUNTIME
+#include <tree_sitter/api.h>
+#endif
+
+#include "tree_sitter_xonsh_api.h"
 
 typedef struct TSLanguage TSLanguage;
 
 TSLanguage *tree_sitter_xonsh(void);
 
+static const char *const line_kind_names[] = {"python", "subprocess", "subprocess_macro", "block_macro"};
+
 static PyObject* _binding_language(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(args)) {
     return PyCapsule_New(tree_sitter_xonsh(), "tree_sitter.Language", NULL);
 }
 
+static PyObject* _binding_register_commands(PyObject *Py_UNUSED(self), PyObject *names) {
+    PyObject *iterator = PyObject_GetIter(names);
+    if (iterator == NULL) {
+        return NULL;
+    }
+    Py_ssize_t registered = 0;
+    PyObject *name;
+    while ((name = PyIter_Next(iterator)) != NULL) {
+        PyObject *encoded = PyUnicode_AsUTF8String(name);
+        Py_DECREF(name);
+        if (encoded == NULL) {
+            Py_DECREF(iterator);
+            return NULL;
+        }
+        char *data;
+        Py_ssize_t length;
+        if (PyBytes_AsStringAndSize(encoded, &data, &length) < 0) {
+            Py_DECREF(encoded);
+            Py_DECREF(iterator);
+            return NULL;
+        }
+        if (tree_sitter_xonsh_register_command(data, (size_t)length)) {
+            registered++;
+        }
+        Py_DECREF(encoded);
+    }
+    Py_DECREF(iterator);
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+    return PyLong_FromSsize_t(registered);
+}
+
+static PyObject* _binding_clear_commands(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(args)) {
+    tree_sitter_xonsh_clear_commands();
+    Py_RETURN_NONE;
+}
+
+static PyObject* _binding_registered_command_count(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(args)) {
+    return PyLong_FromSize_t(tree_sitter_xonsh_registered_command_count());
+}
+
+static PyObject* _binding_classify_line(PyObject *Py_UNUSED(self), PyObject *line) {
+    PyObject *encoded;
+    bool is_text = PyUnicode_Check(line);
+    if (is_text) {
+        encoded = PyUnicode_AsUTF8String(line);
+        if (encoded == NULL) {
+            return NULL;
+        }
+    } else if (PyBytes_Check(line)) {
+        encoded = line;
+        Py_INCREF(encoded);
+    } else {
+        PyErr_SetString(PyExc_TypeError, "classify_line expects str or bytes");
+        return NULL;
+    }
+    char *data;
+    Py_ssize_t length;
+    if (PyBytes_AsStringAndSize(encoded, &data, &length) < 0) {
+        Py_DECREF(encoded);
+        return NULL;
+    }
+    size_t macro_end;
+    TreeSitterXonshLineKind kind = tree_sitter_xonsh_classify_line(data, (size_t)length, &macro_end);
+    if (is_text) {
+        // str indices count code points, not UTF-8 bytes
+        size_t characters = 0;
+        for (size_t i = 0; i < macro_end; i++) {
+            if ((data[i] & 0xC0) != 0x80) {
+                characters++;
+            }
+        }
+        macro_end = characters;
+    }
+    Py_DECREF(encoded);
+    return Py_BuildValue("(sn)", line_kind_names[kind], (Py_ssize_t)macro_end);
+}
+
+#ifdef TREE_SITTER_XONSH_RUNTIME
+
+// parse_many() and parse_buffer(): parse sources on worker threads without
+// the GIL. Each worker owns a TSParser and takes the next source from a shared
+// index; results stay in C until every worker is done and the GIL is back.
+// bytes and buffer-protocol objects (memoryview, mmap, bytearray) are read in
+// place, never copied, except in the 3.8 limited API build.
+
+// The buffer protocol joined the limited API in 3.11
+#if !defined(Py_LIMITED_API) || Py_LIMITED_API >= 0x030B0000
+#define BINDING_HAS_BUFFERS
+#endif
+
+typedef struct {
+    TSSymbol symbol;
+    uint32_t start_byte;
+    uint32_t end_byte;
+} NodeRange;
+
+typedef struct {
+    const char *data;
+    uint32_t length;
+    bool parsed;
+    bool has_error;
+    uint32_t node_count;
+    char *sexp;
+    NodeRange *ranges;
+    uint32_t range_count;
+    uint32_t range_capacity;
+} ParseJob;
+
+typedef struct {
+    ParseJob *jobs;
+    size_t job_count;
+    const bool *wanted_symbols;  // Indexed by symbol; NULL when no node types were asked for
+    bool sexp;
+    bool incompatible;  // A worker's parser refused the language: the runtime's ABI range misses it
+    PyThread_type_lock lock;  // Guards next_job and running
+    size_t next_job;
+    size_t running;
+    PyThread_type_lock done;  // Held until the last worker finishes
+} ParseBatch;
+
+#ifndef BINDING_HAS_BUFFERS
+// Copy a bytes-like source into bytes through a memoryview, for builds that
+// cannot hold its buffer themselves. Returns NULL without an exception set
+// when source is not bytes-like, and rejects what PyBUF_SIMPLE would.
+static PyObject *buffer_copy(PyObject *source) {
+    PyObject *view = PyMemoryView_FromObject(source);
+    if (view == NULL) {
+        if (PyErr_ExceptionMatches(PyExc_TypeError)) {
+            PyErr_Clear();
+        }
+        return NULL;
+    }
+    PyObject *bytes = NULL, *contiguous = PyObject_GetAttrString(view, "c_contiguous");
+    if (contiguous == Py_True) {
+        bytes = PyObject_CallMethod(view, "tobytes", NULL);
+    } else if (contiguous != NULL) {
+        PyErr_SetString(PyExc_BufferError, "source buffer is not C-contiguous");
+    }
+    Py_XDECREF(contiguous);
+    Py_DECREF(view);
+    return bytes;
+}
+#endif
+
+static bool parse_job_add_range(ParseJob *job, TSNode node) {
+    if (job->range_count == job->range_capacity) {
+        uint32_t capacity = job->range_capacity ? job->range_capacity * 2 : 16;
+        NodeRange *ranges = realloc(job->ranges, capacity * sizeof(NodeRange));
+        if (ranges == NULL) {
+            return false;
+        }
+        job->ranges = ranges;
+        job->range_capacity = capacity;
+    }
+    job->ranges[job->range_count++] = (NodeRange){ts_node_symbol(node), ts_node_start_byte(node), ts_node_end_byte(node)};
+    return true;
+}
+
+// TSInput over a job's source: the parser reads the caller's memory in place
+static const char *parse_job_read(void *payload, uint32_t byte_index, TSPoint position, uint32_t *bytes_read) {
+    const ParseJob *job = payload;
+    (void)position;
+    if (byte_index >= job->length) {
+        *bytes_read = 0;
+        return "";
+    }
+    *bytes_read = job->length - byte_index;
+    return job->data + byte_index;
+}
+
+static void parse_job_run(const ParseBatch *batch, TSParser *parser, ParseJob *job) {
+    TSInput input = {.payload = job, .read = parse_job_read, .encoding = TSInputEncodingUTF8};
+    TSTree *tree = ts_parser_parse(parser, NULL, input);
+    if (tree == NULL) {
+        return;
+    }
+    TSNode root = ts_tree_root_node(tree);
+    job->has_error = ts_node_has_error(root);
+    job->node_count = ts_node_descendant_count(root);
+    job->parsed = true;
+
+    if (batch->wanted_symbols != NULL) {
+        TSTreeCursor cursor = ts_tree_cursor_new(root);
+        for (bool more = true; more && job->parsed;) {
+            TSNode node = ts_tree_cursor_current_node(&cursor);
+            if (batch->wanted_symbols[ts_node_symbol(node)]) {
+                job->parsed = parse_job_add_range(job, node);
+            }
+            if (ts_tree_cursor_goto_first_child(&cursor)) {
+                continue;
+            }
+            while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+                if (!ts_tree_cursor_goto_parent(&cursor)) {
+                    more = false;
+                    break;
+                }
+            }
+        }
+        ts_tree_cursor_delete(&cursor);
+    }
+    if (batch->sexp && job->parsed) {
+        job->sexp = ts_node_string(root);
+    }
+    ts_tree_delete(tree);
+}
+
+static void parse_batch_worker(void *payload) {
+    ParseBatch *batch = payload;
+    TSParser *parser = ts_parser_new();
+    if (!ts_parser_set_language(parser, tree_sitter_xonsh())) {
+        PyThread_acquire_lock(batch->lock, WAIT_LOCK);
+        batch->incompatible = true;
+        batch->next_job = batch->job_count;
+        PyThread_release_lock(batch->lock);
+    }
+    for (;;) {
+        PyThread_acquire_lock(batch->lock, WAIT_LOCK);
+        size_t index = batch->next_job++;
+        PyThread_release_lock(batch->lock);
+        if (index >= batch->job_count) {
+            break;
+        }
+        parse_job_run(batch, parser, &batch->jobs[index]);
+    }
+    ts_parser_delete(parser);
+
+    PyThread_acquire_lock(batch->lock, WAIT_LOCK);
+    bool last = --batch->running == 0;
+    PyThread_release_lock(batch->lock);
+    if (last) {
+        PyThread_release_lock(batch->done);
+    }
+}
+
+/**
+ * Run every job of the batch on `workers` threads, the calling one included.
+ * The GIL is released while the calling thread parses and waits. Returns false, with an exception set, if the locks
+ * cannot be made; if extra threads cannot be started, fewer threads do the work.
+ */
+static bool parse_batch_run(ParseBatch *batch, Py_ssize_t workers) {
+    batch->lock = PyThread_allocate_lock();
+    batch->done = PyThread_allocate_lock();
+    if (batch->lock == NULL || batch->done == NULL) {
+        PyErr_NoMemory();
+        return false;
+    }
+    PyThread_acquire_lock(batch->done, WAIT_LOCK);
+    batch->next_job = 0;
+    batch->running = 1;
+
+    for (Py_ssize_t i = 1; i < workers; i++) {
+        PyThread_acquire_lock(batch->lock, WAIT_LOCK);
+        batch->running++;
+        PyThread_release_lock(batch->lock);
+        if (PyThread_start_new_thread(parse_batch_worker, batch) == (unsigned long)-1) {
+            PyThread_acquire_lock(batch->lock, WAIT_LOCK);
+            batch->running--;
+            PyThread_release_lock(batch->lock);
+            break;
+        }
+    }
+    Py_BEGIN_ALLOW_THREADS
+    parse_batch_worker(batch);
+    PyThread_acquire_lock(batch->done, WAIT_LOCK);
+    Py_END_ALLOW_THREADS
+    PyThread_release_lock(batch->done);
+    return true;
+}
+
+static void parse_batch_free(ParseBatch *batch) {
+    for (size_t i = 0; i < batch->job_count; i++) {
+        free(batch->jobs[i].sexp);
+        free(batch->jobs[i].ranges);
+    }
+    PyMem_Free(batch->jobs);
+    PyMem_Free((void *)batch->wanted_symbols);
+    if (batch->lock != NULL) {
+        PyThread_free_lock(batch->lock);
+    }
+    if (batch->done != NULL) {
+        PyThread_free_lock(batch->done);
+    }
+}
+
+/**
+ * Symbols whose node type name is in `names`, as a table indexed by symbol.
+ * Aliased node types have symbols of their own, so each name may set several.
+ */
+static bool *wanted_symbols_new(PyObject *names) {
+    const TSLanguage *language = tree_sitter_xonsh();
+    uint32_t symbol_count = ts_language_symbol_count(language);
+    bool *wanted = PyMem_Calloc(symbol_count, sizeof(bool));
+    if (wanted == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    PyObject *iterator = PyObject_GetIter(names);
+    if (iterator == NULL) {
+        PyMem_Free(wanted);
+        return NULL;
+    }
+    PyObject *name;
+    while ((name = PyIter_Next(iterator)) != NULL) {
+        if (!PyUnicode_Check(name)) {
+            PyErr_Format(PyExc_TypeError, "node_types must be str, got %R", name);
+            Py_DECREF(name);
+            break;
+        }
+        PyObject *encoded = PyUnicode_AsUTF8String(name);
+        Py_DECREF(name);
+        if (encoded == NULL) {
+            break;
+        }
+        const char *type = PyBytes_AsString(encoded);
+        for (TSSymbol symbol = 0; type != NULL && symbol < symbol_count; symbol++) {
+            if (ts_language_symbol_type(language, symbol) != TSSymbolTypeAuxiliary &&
+                strcmp(ts_language_symbol_name(language, symbol), type) == 0) {
+                wanted[symbol] = true;
+            }
+        }
+        Py_DECREF(encoded);
+    }
+    Py_DECREF(iterator);
+    if (PyErr_Occurred()) {
+        PyMem_Free(wanted);
+        return NULL;
+    }
+    return wanted;
+}
+
+static PyObject *parse_job_result(const TSLanguage *language, const ParseJob *job, bool want_ranges) {
+    PyObject *sexp = Py_None, *ranges = Py_None;
+    Py_INCREF(Py_None);
+    Py_INCREF(Py_None);
+    if (job->sexp != NULL) {
+        Py_DECREF(sexp);
+        sexp = PyUnicode_FromString(job->sexp);
+        if (sexp == NULL) {
+            Py_DECREF(ranges);
+            return NULL;
+        }
+    }
+    if (want_ranges) {
+        Py_DECREF(ranges);
+        ranges = PyList_New(job->range_count);
+        for (uint32_t i = 0; ranges != NULL && i < job->range_count; i++) {
+            const NodeRange *range = &job->ranges[i];
+            PyObject *item = Py_BuildValue("(sII)", ts_language_symbol_name(language, range->symbol),
+                                           range->start_byte, range->end_byte);
+            if (item == NULL) {
+                Py_CLEAR(ranges);
+                break;
+            }
+            PyList_SetItem(ranges, i, item);
+        }
+        if (ranges == NULL) {
+            Py_DECREF(sexp);
+            return NULL;
+        }
+    }
+    return Py_BuildValue("(NINN)", PyBool_FromLong(job->has_error), job->node_count, sexp, ranges);
+}
+
+/**
+ * Parse the tuple `items` on `workers` threads and return the list of
+ * parse_job_result() tuples. The tuple and the buffer views taken here keep
+ * every source alive and unchanged while the workers read it, even if the
+ * caller mutates its list: a bytearray or mmap cannot be resized or closed
+ * while a view of it is held.
+ */
+static PyObject *parse_sources(const char *name, PyObject *items, Py_ssize_t workers, PyObject *node_types, int sexp) {
+    Py_ssize_t count = PyTuple_Size(items);
+    PyObject *encoded = PyTuple_New(count);
+    ParseBatch batch = {0};
+    batch.sexp = sexp;
+    batch.job_count = (size_t)count;
+    batch.jobs = PyMem_Calloc(count ? (size_t)count : 1, sizeof(ParseJob));
+#ifdef BINDING_HAS_BUFFERS
+    Py_buffer *views = PyMem_Calloc(count ? (size_t)count : 1, sizeof(Py_buffer));
+    bool *viewed = PyMem_Calloc(count ? (size_t)count : 1, sizeof(bool));
+    bool allocated = views != NULL && viewed != NULL;
+#else
+    bool allocated = true;
+#endif
+    PyObject *results = NULL;
+    if (encoded == NULL || batch.jobs == NULL || !allocated) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+    for (Py_ssize_t i = 0; i < count; i++) {
+        PyObject *source = PyTuple_GetItem(items, i), *bytes;
+        char *data;
+        Py_ssize_t length;
+        if (PyUnicode_Check(source)) {
+            bytes = PyUnicode_AsUTF8String(source);
+            if (bytes == NULL) {
+                goto cleanup;
+            }
+        } else if (PyBytes_Check(source)) {
+            bytes = source;
+            Py_INCREF(bytes);
+#ifdef BINDING_HAS_BUFFERS
+        } else if (PyObject_CheckBuffer(source)) {
+            if (PyObject_GetBuffer(source, &views[i], PyBUF_SIMPLE) < 0) {
+                goto cleanup;
+            }
+            viewed[i] = true;
+            bytes = Py_None;
+            Py_INCREF(bytes);
+#else
+        } else if ((bytes = buffer_copy(source)) != NULL || PyErr_Occurred()) {
+            if (bytes == NULL) {
+                goto cleanup;
+            }
+#endif
+        } else {
+            PyErr_Format(PyExc_TypeError, "%s expects str, bytes or buffer sources, got %R at index %zd", name,
+                         (PyObject *)Py_TYPE(source), i);
+            goto cleanup;
+        }
+        PyTuple_SetItem(encoded, i, bytes);
+#ifdef BINDING_HAS_BUFFERS
+        if (viewed[i]) {
+            data = views[i].buf;
+            length = views[i].len;
+        } else
+#endif
+        if (PyBytes_AsStringAndSize(bytes, &data, &length) < 0) {
+            goto cleanup;
+        }
+        if ((uint64_t)length > UINT32_MAX) {
+            PyErr_Format(PyExc_ValueError, "source at index %zd is larger than 4 GiB", i);
+            goto cleanup;
+        }
+        batch.jobs[i].data = data;
+        batch.jobs[i].length = (uint32_t)length;
+    }
+    if (node_types != Py_None && (batch.wanted_symbols = wanted_symbols_new(node_types)) == NULL) {
+        goto cleanup;
+    }
+
+    if (!parse_batch_run(&batch, workers < count ? workers : (count ? count : 1))) {
+        goto cleanup;
+    }
+
+    const TSLanguage *language = tree_sitter_xonsh();
+    if (batch.incompatible) {
+        PyErr_Format(PyExc_RuntimeError,
+                     "%s: the tree-sitter runtime it was built against loads language versions %d to %d, "
+                     "but this parser is version %u; rebuild tree-sitter-xonsh against a matching runtime",
+                     name, TREE_SITTER_MIN_COMPATIBLE_LANGUAGE_VERSION, TREE_SITTER_LANGUAGE_VERSION,
+                     ts_language_version(language));
+        goto cleanup;
+    }
+    results = PyList_New(count);
+    for (Py_ssize_t i = 0; results != NULL && i < count; i++) {
+        if (!batch.jobs[i].parsed) {
+            PyErr_Format(PyExc_MemoryError, "parsing the source at index %zd ran out of memory", i);
+            Py_CLEAR(results);
+            break;
+        }
+        PyObject *result = parse_job_result(language, &batch.jobs[i], batch.wanted_symbols != NULL);
+        if (result == NULL) {
+            Py_CLEAR(results);
+            break;
+        }
+        PyList_SetItem(results, i, result);
+    }
+
+cleanup:
+    parse_batch_free(&batch);
+#ifdef BINDING_HAS_BUFFERS
+    for (Py_ssize_t i = 0; viewed != NULL && i < count; i++) {
+        if (viewed[i]) {
+            PyBuffer_Release(&views[i]);
+        }
+    }
+    PyMem_Free(views);
+    PyMem_Free(viewed);
+#endif
+    Py_XDECREF(encoded);
+    return results;
+}
+
+static PyObject *_binding_parse_many(PyObject *Py_UNUSED(self), PyObject *args, PyObject *kwargs) {
+    static char *keywords[] = {"sources", "workers", "node_types", "sexp", NULL};
+    PyObject *sources, *node_types = Py_None;
+    Py_ssize_t workers = 0;
+    int sexp = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|n$Op:parse_many", keywords, &sources, &workers,
+                                     &node_types, &sexp)) {
+        return NULL;
+    }
+    if (workers <= 0) {
+        PyObject *os = PyImport_ImportModule("os");
+        PyObject *count = os ? PyObject_CallMethod(os, "cpu_count", NULL) : NULL;
+        Py_XDECREF(os);
+        if (count == NULL) {
+            return NULL;
+        }
+        workers = count == Py_None ? 1 : PyLong_AsSsize_t(count);
+        Py_DECREF(count);
+        if (workers == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+    }
+
+    PyObject *items = PySequence_Tuple(sources);
+    if (items == NULL) {
+        return NULL;
+    }
+    PyObject *results = parse_sources("parse_many", items, workers, node_types, sexp);
+    Py_DECREF(items);
+    return results;
+}
+
+static PyObject *_binding_parse_buffer(PyObject *Py_UNUSED(self), PyObject *args, PyObject *kwargs) {
+    static char *keywords[] = {"source", "node_types", "sexp", NULL};
+    PyObject *source, *node_types = Py_None;
+    int sexp = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|$Op:parse_buffer", keywords, &source, &node_types, &sexp)) {
+        return NULL;
+    }
+    PyObject *items = PyTuple_Pack(1, source);
+    if (items == NULL) {
+        return NULL;
+    }
+    PyObject *results = parse_sources("parse_buffer", items, 1, node_types, sexp);
+    Py_DECREF(items);
+    if (results == NULL) {
+        return NULL;
+    }
+    PyObject *result = PyList_GetItem(results, 0);
+    Py_INCREF(result);
+    Py_DECREF(results);
+    return result;
+}
+
+#else
+
+static PyObject *_binding_parse_many(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(args),
+                                     PyObject *Py_UNUSED(kwargs)) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "parse_many and parse_buffer need tree_sitter_xonsh built against the tree-sitter runtime "
+                    "(install libtree-sitter where pkg-config finds it, or set TS_RUNTIME_CFLAGS "
+                    "and TS_RUNTIME_LIBS, and reinstall)");
+    return NULL;
+}
+
+static PyObject *_binding_parse_buffer(PyObject *self, PyObject *args, PyObject *kwargs) {
+    return _binding_parse_many(self, args, kwargs);
+}
+
+#endif
+
 static struct PyModuleDef_Slot slots[] = {
 #ifdef Py_GIL_DISABLED
     {Py_mod_gil, Py_MOD_GIL_NOT_USED},
@@ -18,6 +589,40 @@ static struct PyModuleDef_Slot slots[] = {
 static PyMethodDef methods[] = {
     {"language", _binding_language, METH_NOARGS,
      "Get the tree-sitter language for this grammar."},
+    {"register_commands", _binding_register_commands, METH_O,
+     "Register extra command names that start bare subprocesses.\n\n"
+     "Takes an iterable of str and returns how many names were accepted.\n"
+     "Only identifier-shaped names of at most 63 bytes are accepted.\n"
+     "The registry is process-wide and may change while other threads parse."},
+    {"clear_commands", _binding_clear_commands, METH_NOARGS,
+     "Forget every command name registered with register_commands()."},
+    {"registered_command_count", _binding_registered_command_count, METH_NOARGS,
+     "Get the number of distinct command names currently registered."},
+    {"classify_line", _binding_classify_line, METH_O,
+     "Classify the statement a line starts without parsing it.\n\n"
+     "Takes a str or bytes and returns (kind, macro_end), where kind is one of\n"
+     "'python', 'subprocess', 'subprocess_macro' or 'block_macro', and macro_end\n"
+     "is where a macro's argument text starts (0 for other kinds), in characters\n"
+     "for str and bytes for bytes."},
+    {"parse_many", (PyCFunction)(void (*)(void))_binding_parse_many, METH_VARARGS | METH_KEYWORDS,
+     "Parse many sources on worker threads, with the GIL released.\n\n"
+     "parse_many(sources, workers=0, *, node_types=None, sexp=False)\n\n"
+     "Takes a sequence of str or bytes and returns one tuple per source, in order:\n"
+     "(has_error, node_count, sexp, ranges). node_count counts every node of the\n"
+     "tree, the root included. sexp is the tree's S-expression when sexp is true,\n"
+     "else None. ranges lists (type, start_byte, end_byte) for each node whose type\n"
+     "is in node_types, in document order, or is None when node_types is None.\n"
+     "workers <= 0 uses os.cpu_count() threads; the calling thread is one of them.\n"
+     "Sources may also be bytes-like objects (memoryview, mmap, bytearray), which\n"
+     "are parsed in place on Python 3.11 and later."},
+    {"parse_buffer", (PyCFunction)(void (*)(void))_binding_parse_buffer, METH_VARARGS | METH_KEYWORDS,
+     "Parse one source in place, with the GIL released.\n\n"
+     "parse_buffer(source, *, node_types=None, sexp=False)\n\n"
+     "source is bytes, str or any object with the buffer protocol, such as an mmap\n"
+     "of a file: on Python 3.11 and later the parser reads its memory without\n"
+     "copying or decoding it, before that it parses a copy. The buffer cannot be\n"
+     "resized or closed while it is parsed. Returns the same\n"
+     "(has_error, node_count, sexp, ranges) tuple as parse_many()."},
     {NULL, NULL, 0, NULL}
 };
 
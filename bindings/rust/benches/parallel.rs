@@ -0,0 +1,100 @@
+//! Scaling of `parallel::Indexer` with its thread count.
+//!
+//! Writes a tree of xonsh files made from the test/corpus inputs to a
+//! temporary directory and indexes it with 1, 2, 4, ... threads up to the
+//! number of available cores. Criterion reports throughput in bytes, so
+//! near-linear scaling shows as throughput doubling with the thread count
+//! until the cores run out.
+//!
+//!   cargo bench --features parallel
+
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::thread;
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use tree_sitter_xonsh::parallel::Indexer;
+
+const DIRECTORIES: usize = 32;
+const FILES_PER_DIRECTORY: usize = 64;
+const FILE_SIZE: usize = 8 * 1024;
+
+fn corpus_inputs() -> Vec<String> {
+    let corpus = Path::new(env!("CARGO_MANIFEST_DIR")).join("test").join("corpus");
+    let mut paths: Vec<PathBuf> = fs::read_dir(&corpus)
+        .expect("the benchmark reads test/corpus from a checkout")
+        .map(|entry| entry.unwrap().path())
+        .filter(|path| path.extension().is_some_and(|extension| extension == "txt"))
+        .collect();
+    paths.sort();
+
+    let mut inputs = Vec::new();
+    for path in paths {
+        let text = fs::read_to_string(path).unwrap();
+        let lines: Vec<&str> = text.lines().collect();
+        // Each test is a title between two `===` lines, the input, a `---` line, the tree
+        let mut i = 0;
+        while i + 2 < lines.len() {
+            if lines[i].starts_with("===") && lines[i + 2].starts_with("===") {
+                let start = i + 3;
+                let end = (start..lines.len()).find(|&j| lines[j].starts_with("---")).unwrap_or(lines.len());
+                inputs.push(lines[start..end].join("\n").trim_end().to_string() + "\n");
+                i = end;
+            } else {
+                i += 1;
+            }
+        }
+    }
+    inputs
+}
+
+/// Writes the file tree and returns its root and total size.
+fn write_tree() -> (PathBuf, u64) {
+    let root = std::env::temp_dir().join(format!("tree-sitter-xonsh-bench-{}", std::process::id()));
+    let _ = fs::remove_dir_all(&root);
+    let inputs = corpus_inputs();
+    let mut next = 0;
+    let mut bytes = 0;
+    for directory in 0..DIRECTORIES {
+        let directory = root.join(format!("package{}", directory % 4)).join(format!("module{directory}"));
+        fs::create_dir_all(&directory).unwrap();
+        for file in 0..FILES_PER_DIRECTORY {
+            let mut source = String::new();
+            while source.len() < FILE_SIZE {
+                source += &inputs[next % inputs.len()];
+                next += 1;
+            }
+            bytes += source.len() as u64;
+            fs::write(directory.join(format!("file{file}.xsh")), source).unwrap();
+        }
+    }
+    (root, bytes)
+}
+
+fn thread_counts() -> Vec<usize> {
+    let cores = thread::available_parallelism().map_or(1, |cores| cores.get());
+    let mut counts: Vec<usize> = (0..).map(|power| 1 << power).take_while(|&count| count < cores).collect();
+    counts.push(cores);
+    counts
+}
+
+fn indexer_scaling(c: &mut Criterion) {
+    let (root, bytes) = write_tree();
+    let mut group = c.benchmark_group("indexer");
+    group.throughput(Throughput::Bytes(bytes));
+    group.sample_size(10);
+    for threads in thread_counts() {
+        group.bench_with_input(BenchmarkId::from_parameter(threads), &threads, |b, &threads| {
+            let indexer = Indexer::new(&root).threads(threads);
+            b.iter(|| {
+                let files = indexer.walk(|_, _, tree| tree.root_node().has_error()).count();
+                assert_eq!(files, DIRECTORIES * FILES_PER_DIRECTORY);
+            });
+        });
+    }
+    group.finish();
+    fs::remove_dir_all(&root).unwrap();
+}
+
+criterion_group!(benches, indexer_scaling);
+criterion_main!(benches);
@@ -0,0 +1,37 @@
+//! What the bundled queries cost an editor at startup.
+//!
+//! `compile/*` is what every consumer that calls `Query::new` on the query
+//! sources pays; `cached/*` is a call to the accessors once the process has
+//! compiled them, which is all every consumer after the first pays.
+//!
+//!   cargo bench --bench queries
+
+use criterion::{criterion_group, criterion_main, Criterion};
+use tree_sitter::{Language, Query};
+
+type Accessor = fn() -> &'static Query;
+
+fn query_startup(c: &mut Criterion) {
+    let language: Language = tree_sitter_xonsh::LANGUAGE.into();
+    let queries: [(&str, &str, Accessor); 3] = [
+        ("highlights", tree_sitter_xonsh::HIGHLIGHTS_QUERY, tree_sitter_xonsh::highlights_query),
+        ("injections", tree_sitter_xonsh::INJECTIONS_QUERY, tree_sitter_xonsh::injections_query),
+        ("locals", tree_sitter_xonsh::LOCALS_QUERY, tree_sitter_xonsh::locals_query),
+    ];
+
+    let mut group = c.benchmark_group("compile");
+    for (name, source, _) in queries {
+        group.bench_function(name, |b| b.iter(|| Query::new(&language, source).unwrap()));
+    }
+    group.finish();
+
+    let mut group = c.benchmark_group("cached");
+    for (name, _, cached) in queries {
+        cached();
+        group.bench_function(name, |b| b.iter(cached));
+    }
+    group.finish();
+}
+
+criterion_group!(benches, query_startup);
+criterion_main!(benches);
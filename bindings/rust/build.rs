@@ -17,5 +17,13 @@ fn main() {
         println!("cargo:rerun-if-changed={}", scanner_path.to_str().unwrap());
     }
 
+    // The scanner pulls in private headers from src/
+    for entry in std::fs::read_dir(src_dir).unwrap().flatten() {
+        let path = entry.path();
+        if path.extension().is_some_and(|ext| ext == "h") {
+            println!("cargo:rerun-if-changed={}", path.to_str().unwrap());
+        }
+    }
+
     c_config.compile("tree-sitter-xonsh");
 }
@@ -18,27 +18,138 @@
 //! [`Parser`]: https://docs.rs/tree-sitter/0.25.10/tree_sitter/struct.Parser.html
 //! [tree-sitter]: https://tree-sitter.github.io/
 
+use std::os::raw::{c_char, c_int};
+use std::sync::OnceLock;
+
+use tree_sitter::Query;
 use tree_sitter_language::LanguageFn;
 
+#[cfg(feature = "parallel")]
+pub mod parallel;
+
 extern "C" {
     fn tree_sitter_xonsh() -> *const ();
+    fn tree_sitter_xonsh_register_command(name: *const c_char, length: usize) -> bool;
+    fn tree_sitter_xonsh_clear_commands();
+    fn tree_sitter_xonsh_registered_command_count() -> usize;
+    fn tree_sitter_xonsh_classify_line(line: *const c_char, length: usize, macro_end: *mut usize) -> c_int;
 }
 
 /// The tree-sitter [`LanguageFn`] for this grammar.
 pub const LANGUAGE: LanguageFn = unsafe { LanguageFn::from_raw(tree_sitter_xonsh) };
 
+/// Register an extra command name, so that lines starting with it parse as
+/// bare subprocesses even without flags, pipes or other shell signals.
+///
+/// Returns `false` if the name can never start a bare subprocess: only
+/// identifier-shaped names of at most 63 bytes are accepted.
+///
+/// The registry is process-wide and safe to change while other threads
+/// parse. A parse running meanwhile may see a name from the next statement
+/// on, so register names up front to have every line see them.
+pub fn register_command(name: &str) -> bool {
+    unsafe { tree_sitter_xonsh_register_command(name.as_ptr().cast(), name.len()) }
+}
+
+/// Register many command names at once, e.g. a snapshot of `$PATH`.
+///
+/// Returns how many names were accepted. See [`register_command`].
+pub fn register_commands<I, S>(names: I) -> usize
+where
+    I: IntoIterator<Item = S>,
+    S: AsRef<str>,
+{
+    names
+        .into_iter()
+        .filter(|name| register_command(name.as_ref()))
+        .count()
+}
+
+/// Forget every command name registered with [`register_command`].
+pub fn clear_commands() {
+    unsafe { tree_sitter_xonsh_clear_commands() }
+}
+
+/// Number of distinct command names currently registered.
+pub fn registered_command_count() -> usize {
+    unsafe { tree_sitter_xonsh_registered_command_count() }
+}
+
+/// What a line of xonsh starts, as decided by [`classify_line`].
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum LineKind {
+    /// A Python statement, or a blank or comment line.
+    Python,
+    /// A bare subprocess, like `ls -la` or `cd /tmp`.
+    Subprocess,
+    /// A subprocess macro like `echo! text`; `macro_end` is the byte offset
+    /// where its argument text starts.
+    SubprocessMacro { macro_end: usize },
+    /// A block macro like `with! Context():`; `macro_end` is the byte offset
+    /// just past `with!`.
+    BlockMacro { macro_end: usize },
+}
+
+/// Classify the statement at the start of `line` the way the scanner does,
+/// without building a tree.
+///
+/// Safe to call from any thread, while others parse or change the command
+/// registry.
+pub fn classify_line(line: impl AsRef<[u8]>) -> LineKind {
+    let line = line.as_ref();
+    let mut macro_end = 0;
+    let kind = unsafe { tree_sitter_xonsh_classify_line(line.as_ptr().cast(), line.len(), &mut macro_end) };
+    match kind {
+        1 => LineKind::Subprocess,
+        2 => LineKind::SubprocessMacro { macro_end },
+        3 => LineKind::BlockMacro { macro_end },
+        _ => LineKind::Python,
+    }
+}
+
 /// The content of the [`node-types.json`] file for this grammar.
 ///
 /// [`node-types.json`]: https://tree-sitter.github.io/tree-sitter/using-parsers/6-static-node-types
 pub const NODE_TYPES: &str = include_str!("../../src/node-types.json");
 
-// NOTE: uncomment these to include any queries that this grammar contains:
+/// The syntax highlighting query for this grammar.
+pub const HIGHLIGHTS_QUERY: &str = include_str!("../../queries/highlights.scm");
+
+/// The language injection query for this grammar.
+pub const INJECTIONS_QUERY: &str = include_str!("../../queries/injections.scm");
+
+/// The local-variable query for this grammar.
+pub const LOCALS_QUERY: &str = include_str!("../../queries/locals.scm");
+
+// NOTE: uncomment this to include a tags query if this grammar gets one:
 
-// pub const HIGHLIGHTS_QUERY: &str = include_str!("../../queries/highlights.scm");
-// pub const INJECTIONS_QUERY: &str = include_str!("../../queries/injections.scm");
-// pub const LOCALS_QUERY: &str = include_str!("../../queries/locals.scm");
 // pub const TAGS_QUERY: &str = include_str!("../../queries/tags.scm");
 
+static HIGHLIGHTS: OnceLock<Query> = OnceLock::new();
+static INJECTIONS: OnceLock<Query> = OnceLock::new();
+static LOCALS: OnceLock<Query> = OnceLock::new();
+
+fn cached_query(cell: &'static OnceLock<Query>, source: &str) -> &'static Query {
+    cell.get_or_init(|| Query::new(&LANGUAGE.into(), source).expect("Error compiling a bundled Xonsh query"))
+}
+
+/// [`HIGHLIGHTS_QUERY`], compiled on first use and shared by the whole
+/// process. Compiling it takes milliseconds, so prefer this to
+/// `Query::new` in code that runs at every editor start.
+pub fn highlights_query() -> &'static Query {
+    cached_query(&HIGHLIGHTS, HIGHLIGHTS_QUERY)
+}
+
+/// [`INJECTIONS_QUERY`], compiled once per process. See [`highlights_query`].
+pub fn injections_query() -> &'static Query {
+    cached_query(&INJECTIONS, INJECTIONS_QUERY)
+}
+
+/// [`LOCALS_QUERY`], compiled once per process. See [`highlights_query`].
+pub fn locals_query() -> &'static Query {
+    cached_query(&LOCALS, LOCALS_QUERY)
+}
+
 #[cfg(test)]
 mod tests {
     #[test]
@@ -48,4 +159,37 @@ mod tests {
             .set_language(&super::LANGUAGE.into())
             .expect("Error loading Xonsh parser");
     }
+
+    #[test]
+    fn test_registered_command_starts_bare_subprocess() {
+        let mut parser = tree_sitter::Parser::new();
+        parser
+            .set_language(&super::LANGUAGE.into())
+            .expect("Error loading Xonsh parser");
+
+        assert!(super::register_command("myregisteredapp"));
+        assert!(!super::register_command("not-an-identifier"));
+        let tree = parser.parse("myregisteredapp\n", None).unwrap();
+        let statement = tree.root_node().child(0).unwrap();
+        super::clear_commands();
+        assert_eq!(statement.kind(), "bare_subprocess");
+    }
+
+    #[test]
+    fn test_classify_line() {
+        use super::{classify_line, LineKind};
+
+        assert_eq!(classify_line("ls -la /tmp"), LineKind::Subprocess);
+        assert_eq!(classify_line(b"x = 1"), LineKind::Python);
+        assert_eq!(classify_line("with! Context():"), LineKind::BlockMacro { macro_end: 5 });
+        assert_eq!(classify_line("  echo! hello"), LineKind::SubprocessMacro { macro_end: 8 });
+    }
+
+    #[test]
+    fn test_queries_compile_once() {
+        for query in [super::highlights_query, super::injections_query, super::locals_query] {
+            assert!(std::ptr::eq(query(), query()));
+        }
+        assert!(super::highlights_query().pattern_count() > 0);
+    }
 }
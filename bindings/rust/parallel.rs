@@ -0,0 +1,414 @@
+//! Parsing many xonsh files at once, behind the `parallel` feature.
+//!
+//! [`with_parser`] lends each thread its own [`Parser`], created on first use
+//! and kept for the thread's life, so a worker pays for `Parser::new` once.
+//! [`Indexer`] walks a directory tree on a pool of such threads and parses
+//! every xonsh file it finds, streaming one [`FileResult`] per file:
+//!
+//! ```no_run
+//! use tree_sitter_xonsh::parallel::Indexer;
+//!
+//! for file in Indexer::new("path/to/repo").walk(|_path, _source, tree| tree.root_node().has_error()) {
+//!     match file.result {
+//!         Ok(true) => println!("{}: syntax errors", file.path.display()),
+//!         Ok(false) => {}
+//!         Err(error) => eprintln!("{}: {error}", file.path.display()),
+//!     }
+//! }
+//! ```
+//!
+//! The walk is work-stealing: each worker keeps a deque of directories and
+//! files, works from its back and, when it runs dry, steals from the front of
+//! another's. A directory listing is split among the workers as soon as it is
+//! read, so one large subtree does not leave the others idle. Idle workers
+//! sleep on a condition variable until new work is queued or the walk ends.
+//!
+//! A panic in the walk's callback stops the walk and is resumed on the
+//! thread that iterates over its results.
+
+use std::any::Any;
+use std::cell::RefCell;
+use std::collections::VecDeque;
+use std::fs;
+use std::io;
+use std::panic::{self, AssertUnwindSafe};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::mpsc::{self, Receiver, SyncSender};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::{self, JoinHandle};
+
+use tree_sitter::{Parser, Tree};
+
+thread_local! {
+    static PARSER: RefCell<Option<Parser>> = const { RefCell::new(None) };
+}
+
+/// Run `f` with this thread's xonsh [`Parser`], creating it on first use.
+///
+/// The parser keeps no tree between calls: pass an old tree to
+/// [`Parser::parse`] yourself for incremental parsing.
+///
+/// # Panics
+///
+/// If `f` calls `with_parser` again.
+pub fn with_parser<R>(f: impl FnOnce(&mut Parser) -> R) -> R {
+    PARSER.with(|cell| {
+        let mut slot = cell.borrow_mut();
+        let parser = slot.get_or_insert_with(|| {
+            let mut parser = Parser::new();
+            parser
+                .set_language(&crate::LANGUAGE.into())
+                .expect("Error loading Xonsh parser");
+            parser
+        });
+        f(parser)
+    })
+}
+
+/// Parse `source` with this thread's parser. See [`with_parser`].
+pub fn parse(source: impl AsRef<[u8]>) -> Option<Tree> {
+    with_parser(|parser| parser.parse(source, None))
+}
+
+/// What [`Indexer::walk`] yields for each file.
+#[derive(Debug)]
+pub struct FileResult<T> {
+    pub path: PathBuf,
+    /// What the walk's callback returned, or why the file could not be read
+    /// or parsed.
+    pub result: io::Result<T>,
+}
+
+/// Whether `path` names a xonsh file: `*.xsh`, `.xonshrc` or `xonshrc`.
+pub fn is_xonsh_file(path: &Path) -> bool {
+    path.extension().is_some_and(|extension| extension == "xsh")
+        || path
+            .file_name()
+            .is_some_and(|name| name == ".xonshrc" || name == "xonshrc")
+}
+
+/// Walks a directory tree and parses its xonsh files on a thread pool.
+#[derive(Clone)]
+pub struct Indexer {
+    roots: Vec<PathBuf>,
+    threads: usize,
+    filter: fn(&Path) -> bool,
+}
+
+impl Indexer {
+    /// Walk `root`, or parse it if it is a file, with one thread per
+    /// available core and [`is_xonsh_file`] as the filter.
+    pub fn new(root: impl Into<PathBuf>) -> Self {
+        Indexer {
+            roots: vec![root.into()],
+            threads: thread::available_parallelism().map_or(1, |threads| threads.get()),
+            filter: is_xonsh_file,
+        }
+    }
+
+    /// Also walk `root`.
+    pub fn root(mut self, root: impl Into<PathBuf>) -> Self {
+        self.roots.push(root.into());
+        self
+    }
+
+    /// Use `threads` worker threads (at least one).
+    pub fn threads(mut self, threads: usize) -> Self {
+        self.threads = threads.max(1);
+        self
+    }
+
+    /// Parse the files for which `filter` returns true. Roots that are files
+    /// are parsed whatever it says.
+    pub fn filter(mut self, filter: fn(&Path) -> bool) -> Self {
+        self.filter = filter;
+        self
+    }
+
+    /// Start the walk. `summarize` runs on the worker that parsed each file,
+    /// with its path, its bytes and its tree, and its result is yielded by the
+    /// returned iterator, in no particular order. Keep the work that scales in
+    /// `summarize` rather than in the loop over the iterator.
+    ///
+    /// Symbolic links are not followed. Dropping the iterator stops the walk.
+    /// If `summarize` panics, the walk stops and the iterator's next call to
+    /// `next` resumes the panic.
+    pub fn walk<T, F>(&self, summarize: F) -> Files<T>
+    where
+        T: Send + 'static,
+        F: Fn(&Path, &[u8], &Tree) -> T + Send + Sync + 'static,
+    {
+        let shared = Arc::new(Shared {
+            queues: (0..self.threads).map(|_| Mutex::new(VecDeque::new())).collect(),
+            pending: AtomicUsize::new(self.roots.len()),
+            stopped: AtomicBool::new(false),
+            generation: Mutex::new(0),
+            wakeup: Condvar::new(),
+            filter: self.filter,
+        });
+        for (index, root) in self.roots.iter().enumerate() {
+            shared.queues[index % self.threads]
+                .lock()
+                .unwrap()
+                .push_back(Work::Root(root.clone()));
+        }
+
+        let summarize = Arc::new(summarize);
+        let (sender, receiver) = mpsc::sync_channel(self.threads * 64);
+        let workers = (0..self.threads)
+            .map(|index| {
+                let shared = Arc::clone(&shared);
+                let summarize = Arc::clone(&summarize);
+                let sender = sender.clone();
+                thread::Builder::new()
+                    .name(format!("tree-sitter-xonsh-{index}"))
+                    .spawn(move || shared.work(index, &*summarize, &sender))
+                    .expect("failed to spawn an indexer thread")
+            })
+            .collect();
+        Files {
+            receiver: Some(receiver),
+            workers,
+            shared,
+        }
+    }
+}
+
+/// The per-file results of [`Indexer::walk`], as the workers produce them.
+pub struct Files<T> {
+    receiver: Option<Receiver<Message<T>>>,
+    workers: Vec<JoinHandle<()>>,
+    shared: Arc<Shared>,
+}
+
+impl<T> Iterator for Files<T> {
+    type Item = FileResult<T>;
+
+    fn next(&mut self) -> Option<FileResult<T>> {
+        match self.receiver.as_ref()?.recv().ok()? {
+            Message::File(file) => Some(file),
+            Message::Panic(payload) => {
+                self.receiver = None;
+                panic::resume_unwind(payload)
+            }
+        }
+    }
+}
+
+impl<T> Drop for Files<T> {
+    fn drop(&mut self) {
+        self.shared.stop();
+        // Unblocks workers waiting for room in the channel
+        self.receiver = None;
+        for worker in self.workers.drain(..) {
+            let _ = worker.join();
+        }
+    }
+}
+
+enum Message<T> {
+    File(FileResult<T>),
+    Panic(Box<dyn Any + Send>),
+}
+
+enum Work {
+    Root(PathBuf),
+    Directory(PathBuf),
+    File(PathBuf),
+}
+
+struct Shared {
+    queues: Vec<Mutex<VecDeque<Work>>>,
+    // Work queued or being done; the walk is over when it drops to zero
+    pending: AtomicUsize,
+    stopped: AtomicBool,
+    // Bumped whenever there is something new for an idle worker to see:
+    // queued work, the end of the walk or a stop
+    generation: Mutex<u64>,
+    wakeup: Condvar,
+    filter: fn(&Path) -> bool,
+}
+
+/// Marks a work item done when dropped, even if it panicked.
+struct Done<'a>(&'a Shared);
+
+impl Drop for Done<'_> {
+    fn drop(&mut self) {
+        if self.0.pending.fetch_sub(1, Ordering::AcqRel) == 1 {
+            self.0.wake();
+        }
+    }
+}
+
+impl Shared {
+    fn work<T, F>(&self, index: usize, summarize: &F, sender: &SyncSender<Message<T>>)
+    where
+        F: Fn(&Path, &[u8], &Tree) -> T,
+    {
+        while !self.stopped.load(Ordering::Relaxed) {
+            // Read before looking for work, so a wake-up in between is not lost
+            let generation = *self.generation.lock().unwrap();
+            let Some(work) = self.next_work(index) else {
+                if self.pending.load(Ordering::Acquire) == 0 {
+                    return;
+                }
+                // Someone is still listing a directory or parsing
+                let _guard = self
+                    .wakeup
+                    .wait_while(self.generation.lock().unwrap(), |current| {
+                        *current == generation && !self.stopped.load(Ordering::Relaxed)
+                    })
+                    .unwrap();
+                continue;
+            };
+            let _done = Done(self);
+            let message = match panic::catch_unwind(AssertUnwindSafe(|| self.run(index, work, summarize))) {
+                Ok(result) => result.map(Message::File),
+                Err(payload) => {
+                    self.stop();
+                    Some(Message::Panic(payload))
+                }
+            };
+            if let Some(message) = message {
+                if sender.send(message).is_err() {
+                    self.stop();
+                }
+            }
+        }
+    }
+
+    fn run<T, F>(&self, index: usize, work: Work, summarize: &F) -> Option<FileResult<T>>
+    where
+        F: Fn(&Path, &[u8], &Tree) -> T,
+    {
+        match work {
+            Work::Root(path) => match fs::metadata(&path) {
+                Ok(metadata) if metadata.is_dir() => self.list(index, path),
+                Ok(_) => Some(parse_file(path, summarize)),
+                Err(error) => Some(FileResult { path, result: Err(error) }),
+            },
+            Work::Directory(path) => self.list(index, path),
+            Work::File(path) => Some(parse_file(path, summarize)),
+        }
+    }
+
+    fn wake(&self) {
+        *self.generation.lock().unwrap() += 1;
+        self.wakeup.notify_all();
+    }
+
+    fn stop(&self) {
+        self.stopped.store(true, Ordering::Relaxed);
+        self.wake();
+    }
+
+    /// Pop from the back of our own queue, else steal from the front of the
+    /// next non-empty one.
+    fn next_work(&self, index: usize) -> Option<Work> {
+        if let Some(work) = self.queues[index].lock().unwrap().pop_back() {
+            return Some(work);
+        }
+        let count = self.queues.len();
+        (1..count).find_map(|offset| self.queues[(index + offset) % count].lock().unwrap().pop_front())
+    }
+
+    /// Queue a directory's subdirectories and xonsh files on our own queue.
+    /// Only a listing error is reported.
+    fn list<T>(&self, index: usize, path: PathBuf) -> Option<FileResult<T>> {
+        let entries = match fs::read_dir(&path) {
+            Ok(entries) => entries,
+            Err(error) => return Some(FileResult { path, result: Err(error) }),
+        };
+        let mut found = Vec::new();
+        for entry in entries.flatten() {
+            let Ok(file_type) = entry.file_type() else {
+                continue;
+            };
+            let path = entry.path();
+            if file_type.is_dir() {
+                found.push(Work::Directory(path));
+            } else if file_type.is_file() && (self.filter)(&path) {
+                found.push(Work::File(path));
+            }
+        }
+        if found.is_empty() {
+            return None;
+        }
+        self.pending.fetch_add(found.len(), Ordering::Relaxed);
+        self.queues[index].lock().unwrap().extend(found);
+        self.wake();
+        None
+    }
+}
+
+fn parse_file<T, F>(path: PathBuf, summarize: &F) -> FileResult<T>
+where
+    F: Fn(&Path, &[u8], &Tree) -> T,
+{
+    let result = fs::read(&path).and_then(|source| {
+        let tree = parse(&source).ok_or_else(|| io::Error::other("parse was cancelled"))?;
+        Ok(summarize(&path, &source, &tree))
+    });
+    FileResult { path, result }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_with_parser_reuses_the_thread_parser() {
+        let first = with_parser(|parser| parser as *const Parser);
+        let second = with_parser(|parser| parser as *const Parser);
+        assert_eq!(first, second);
+        assert!(!parse("ls -la\n").unwrap().root_node().has_error());
+    }
+
+    #[test]
+    fn test_indexer_parses_every_xonsh_file() {
+        let root = std::env::temp_dir().join(format!("tree-sitter-xonsh-indexer-{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        for directory in 0..8 {
+            let nested = root.join(format!("d{directory}")).join("nested");
+            fs::create_dir_all(&nested).unwrap();
+            for file in 0..16 {
+                let source = if file == 0 { "x = (1,\n" } else { "ls -la\nx = $HOME\n" };
+                fs::write(nested.join(format!("f{file}.xsh")), source).unwrap();
+            }
+            fs::write(nested.join("README.md"), "# not xonsh\n").unwrap();
+        }
+        fs::write(root.join(".xonshrc"), "aliases['ll'] = 'ls -l'\n").unwrap();
+
+        for threads in [1, 4] {
+            let mut files: Vec<_> = Indexer::new(&root)
+                .threads(threads)
+                .walk(|_, _, tree| tree.root_node().has_error())
+                .map(|file| (file.path, file.result.unwrap()))
+                .collect();
+            files.sort();
+            assert_eq!(files.len(), 8 * 16 + 1);
+            assert_eq!(files.iter().filter(|(_, has_error)| *has_error).count(), 8);
+        }
+
+        let mut files = Indexer::new(&root).threads(2).walk(|_, source, _| source.len());
+        assert!(files.next().is_some());
+        drop(files);
+
+        for threads in [1, 4] {
+            let walk = panic::catch_unwind(|| {
+                Indexer::new(&root)
+                    .threads(threads)
+                    .walk(|path, _, _| {
+                        if path.ends_with("d3/nested/f7.xsh") {
+                            panic!("summarize failed");
+                        }
+                    })
+                    .count()
+            });
+            let payload = walk.expect_err("the panic in summarize reaches the iterator");
+            assert_eq!(payload.downcast_ref::<&str>(), Some(&"summarize failed"));
+        }
+        fs::remove_dir_all(&root).unwrap();
+    }
+}
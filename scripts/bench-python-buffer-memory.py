@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+Peak memory of parsing mmap'ed files with and without copying them.
+
+Writes --files files of --size MiB each, made from the test/corpus inputs,
+to a temporary directory. Then, in a fresh process per mode, parses them one
+after the other:
+
+  read         open(path, "rb").read(), then parse_buffer() on the bytes
+  mmap_copy    bytes(mmap), the usual way to hand an mmap to a parser
+  mmap_decode  mmap decoded to str, which parse_many() encodes back to UTF-8
+  mmap         parse_buffer(mmap): the parser reads the mapping in place
+
+Prints one JSON object per mode:
+
+  {"mode":"mmap","files":16,"bytes":...,"seconds":...,"peak_rss_kb":...,
+   "peak_anonymous_kb":...,"peak_python_kb":...}
+
+peak_python_kb is the tracemalloc peak, which is the copies only: the
+parser's trees are allocated in C. peak_anonymous_kb is the largest private
+resident memory seen right after a parse (Linux only), copies and trees
+included. peak_rss_kb also counts the pages of the mapping that were read,
+which are page cache the kernel can drop at any time.
+
+  python scripts/bench-python-buffer-memory.py [--files N] [--size MIB]
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+TEST_HEADER = re.compile(rb"^={3,}\n.*?\n={3,}\n", re.M | re.S)
+TEST_DIVIDER = re.compile(rb"^-{3,}\n", re.M)
+
+CHILD = r"""
+import json, mmap, resource, sys, time, tracemalloc
+import tree_sitter_xonsh
+
+mode, paths = sys.argv[1], sys.argv[2:]
+
+
+def anonymous_kb():
+    # Private memory: the copies and the C heap, not the pages of a mapping
+    try:
+        with open("/proc/self/status") as status:
+            return next(int(line.split()[1]) for line in status if line.startswith("RssAnon:"))
+    except (OSError, StopIteration):
+        return 0
+
+
+peak_anonymous = 0
+tracemalloc.start()
+start = time.perf_counter()
+for path in paths:
+    with open(path, "rb") as file, mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+        if mode == "read":
+            source = file.read()
+        elif mode == "mmap_copy":
+            source = bytes(mapped)
+        elif mode == "mmap_decode":
+            source = mapped[:].decode()
+        else:
+            source = mapped
+        if mode == "mmap_decode":
+            tree_sitter_xonsh.parse_many([source], 1)
+        else:
+            tree_sitter_xonsh.parse_buffer(source)
+        peak_anonymous = max(peak_anonymous, anonymous_kb())
+        del source
+seconds = time.perf_counter() - start
+print(json.dumps({
+    "seconds": round(seconds, 4),
+    "peak_rss_kb": resource.getrusage(resource.RUSAGE_SELF).ru_maxrss,
+    "peak_anonymous_kb": peak_anonymous,
+    "peak_python_kb": tracemalloc.get_traced_memory()[1] // 1024,
+}))
+"""
+
+
+def write_files(directory, count, size):
+    inputs = []
+    for path in sorted((ROOT / "test" / "corpus").glob("*.txt")):
+        for test in TEST_HEADER.split(path.read_bytes())[1:]:
+            inputs.append(TEST_DIVIDER.split(test, 1)[0].strip(b"\n") + b"\n")
+    chunk = b"".join(inputs)
+    paths = []
+    for index in range(count):
+        path = Path(directory) / f"file{index}.xsh"
+        path.write_bytes((chunk * (size // len(chunk) + 1))[:size])
+        paths.append(str(path))
+    return paths
+
+
+def main():
+    arguments = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    arguments.add_argument("--files", type=int, default=16)
+    arguments.add_argument("--size", type=int, default=16, help="MiB per file")
+    options = arguments.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        paths = write_files(directory, options.files, options.size << 20)
+        for mode in ("read", "mmap_copy", "mmap_decode", "mmap"):
+            result = json.loads(subprocess.check_output([sys.executable, "-c", CHILD, mode, *paths]))
+            print(json.dumps({
+                "mode": mode,
+                "files": len(paths),
+                "bytes": len(paths) * (options.size << 20),
+                **result,
+            }), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""
+Parse time per byte of single-line statements as the line grows.
+
+Parses an assignment, a call, a flag line, a pipeline, a line of bare words
+and a string, each at every --sizes length, and keeps the best of --repeat
+runs. Linear parsing keeps ns_per_byte flat across sizes. Prints one JSON
+object per line and size:
+
+  {"line":"flags","bytes":262144,"ns_per_byte":...}
+
+bindings/python/tests/test_scaling.py checks the same lines with a read
+count instead of time, so it cannot flake.
+
+  python scripts/bench-python-line-scaling.py [--sizes BYTES ...] [--repeat N]
+"""
+
+import argparse
+import json
+import sys
+import time
+from pathlib import Path
+
+from tree_sitter import Language, Parser
+import tree_sitter_xonsh
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent / "bindings" / "python" / "tests"))
+from test_scaling import LINES, make_line  # noqa: E402
+
+
+def best_ns(parser, source, repeat):
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter_ns()
+        parser.parse(source)
+        elapsed = time.perf_counter_ns() - start
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+
+def main():
+    arguments = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    arguments.add_argument("--sizes", type=int, nargs="*", default=[4 * 1024, 32 * 1024, 256 * 1024])
+    arguments.add_argument("--repeat", type=int, default=5)
+    options = arguments.parse_args()
+
+    parser = Parser(Language(tree_sitter_xonsh.language()))
+    for name, (head, body) in LINES.items():
+        for size in options.sizes:
+            source = make_line(head, body, size)
+            nanoseconds = best_ns(parser, source, options.repeat)
+            print(json.dumps({
+                "line": name,
+                "bytes": len(source),
+                "ns_per_byte": round(nanoseconds / len(source), 2),
+            }), flush=True)
+
+
+if __name__ == "__main__":
+    main()
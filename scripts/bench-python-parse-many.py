@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+Compares parse_many() with a plain Python loop over the py-tree-sitter Parser.
+
+Both parse the same sources and compute the same per-file summary
+(has_error and the node count). The loop holds the GIL for the whole batch;
+parse_many() releases it and spreads the sources over worker threads. Prints
+one JSON object per run:
+
+  {"mode":"parse_many","workers":8,"files":1000,"bytes":...,"seconds":...,"files_per_s":...}
+
+Sources are the test/corpus inputs, repeated until there are --files of them.
+
+  python scripts/bench-python-parse-many.py [--files N] [--repeat N] [--workers N ...]
+"""
+
+import argparse
+import json
+import os
+import re
+import time
+from pathlib import Path
+
+from tree_sitter import Language, Parser
+import tree_sitter_xonsh
+
+ROOT = Path(__file__).resolve().parent.parent
+TEST_HEADER = re.compile(rb"^={3,}\n.*?\n={3,}\n", re.M | re.S)
+TEST_DIVIDER = re.compile(rb"^-{3,}\n", re.M)
+
+
+def corpus_inputs():
+    inputs = []
+    for path in sorted((ROOT / "test" / "corpus").glob("*.txt")):
+        for test in TEST_HEADER.split(path.read_bytes())[1:]:
+            inputs.append(TEST_DIVIDER.split(test, 1)[0].strip(b"\n") + b"\n")
+    return inputs
+
+
+def python_loop(sources):
+    parser = Parser(Language(tree_sitter_xonsh.language()))
+    results = []
+    for source in sources:
+        root = parser.parse(source).root_node
+        results.append((root.has_error, root.descendant_count))
+    return results
+
+
+def best_of(repeat, run):
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = run()
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+    return best, result
+
+
+def report(mode, workers, sources, seconds):
+    print(json.dumps({
+        "mode": mode,
+        "workers": workers,
+        "files": len(sources),
+        "bytes": sum(map(len, sources)),
+        "seconds": round(seconds, 4),
+        "files_per_s": round(len(sources) / seconds, 1),
+    }), flush=True)
+
+
+def main():
+    arguments = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    arguments.add_argument("--files", type=int, default=1000)
+    arguments.add_argument("--repeat", type=int, default=5)
+    arguments.add_argument("--workers", type=int, nargs="*", default=[1, os.cpu_count() or 1])
+    options = arguments.parse_args()
+
+    inputs = corpus_inputs()
+    sources = (inputs * (options.files // len(inputs) + 1))[:options.files]
+
+    seconds, expected = best_of(options.repeat, lambda: python_loop(sources))
+    report("python_loop", 1, sources, seconds)
+    for workers in options.workers:
+        seconds, results = best_of(options.repeat, lambda: tree_sitter_xonsh.parse_many(sources, workers))
+        if [result[:2] for result in results] != expected:
+            raise SystemExit(f"parse_many with {workers} workers disagrees with the Python loop")
+        report("parse_many", workers, sources, seconds)
+
+
+if __name__ == "__main__":
+    main()
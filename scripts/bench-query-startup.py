@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+Measures what the bundled queries cost an editor at startup.
+
+Each run is a fresh Python process in which --consumers plugins all want the
+highlights, injections and locals queries. In "compile" mode every plugin
+builds its own tree_sitter.Query from the query sources; in "cached" mode
+every plugin calls highlights_query() and friends, so only the first pays.
+Prints one JSON object per mode with the median over --runs processes:
+
+  {"mode":"cached","consumers":3,"runs":20,"first_ms":...,"total_ms":...}
+
+  python scripts/bench-query-startup.py [--consumers N] [--runs N]
+"""
+
+import argparse
+import json
+import statistics
+import subprocess
+import sys
+
+CHILD = r"""
+import json, sys, time
+from tree_sitter import Language, Query
+import tree_sitter_xonsh as xonsh
+
+mode, consumers = sys.argv[1], int(sys.argv[2])
+sources = [xonsh.HIGHLIGHTS_QUERY, xonsh.INJECTIONS_QUERY, xonsh.LOCALS_QUERY]
+accessors = [xonsh.highlights_query, xonsh.injections_query, xonsh.locals_query]
+times = []
+for _ in range(consumers):
+    start = time.perf_counter()
+    if mode == "compile":
+        language = Language(xonsh.language())
+        queries = [Query(language, source) for source in sources]
+    else:
+        queries = [accessor() for accessor in accessors]
+    times.append((time.perf_counter() - start) * 1000)
+print(json.dumps(times))
+"""
+
+
+def main():
+    arguments = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    arguments.add_argument("--consumers", type=int, default=3)
+    arguments.add_argument("--runs", type=int, default=20)
+    options = arguments.parse_args()
+
+    for mode in ("compile", "cached"):
+        runs = [
+            json.loads(subprocess.check_output([sys.executable, "-c", CHILD, mode, str(options.consumers)]))
+            for _ in range(options.runs)
+        ]
+        print(json.dumps({
+            "mode": mode,
+            "consumers": options.consumers,
+            "runs": options.runs,
+            "first_ms": round(statistics.median(times[0] for times in runs), 3),
+            "total_ms": round(statistics.median(sum(times) for times in runs), 3),
+        }), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,231 @@
+#!/usr/bin/env node
+/**
+ * @file Generates src/scanner_tables.h from the word lists in src/wordlists/
+ * @license MIT
+ *
+ * Each word list becomes a lookup function that switches on the length and
+ * first character of the candidate and then compares the remaining bytes of
+ * the few words in that bucket, so membership tests are constant time and
+ * need no strlen.
+ *
+ * The header also carries a 256-entry character class table, for character
+ * sets that would otherwise take a chain of comparisons.
+ *
+ * Usage:
+ *   node scripts/generate-scanner-tables.js          # (re)write the header
+ *   node scripts/generate-scanner-tables.js --check  # fail if it is stale
+ */
+
+const fs = require('fs');
+const path = require('path');
+
+const root = path.join(__dirname, '..');
+const output = path.join(root, 'src', 'scanner_tables.h');
+
+const tables = [
+  {
+    name: 'is_python_keyword',
+    list: 'python_keywords.txt',
+    doc: 'Check if the identifier matches a Python keyword',
+  },
+  {
+    name: 'is_python_operator_keyword',
+    list: 'python_operator_keywords.txt',
+    doc: 'Check if the identifier matches a Python operator keyword',
+  },
+  {
+    name: 'is_shell_command',
+    list: 'shell_commands.txt',
+    doc: 'Check if the identifier matches a known shell command',
+  },
+];
+
+/**
+ * Character classes, one bit each in char_classes[]. Only ASCII has classes:
+ * identifiers in detection are ASCII, so code points 128-255 stay 0.
+ */
+const charClasses = [
+  {
+    name: 'CHAR_IDENTIFIER_START',
+    doc: 'a-z, A-Z or _',
+    test: (c) => /[A-Za-z_]/.test(c),
+  },
+  {
+    name: 'CHAR_IDENTIFIER',
+    doc: 'Identifier start or digit',
+    test: (c) => /[A-Za-z_0-9]/.test(c),
+  },
+  {
+    name: 'CHAR_STRING_PREFIX',
+    doc: 'String prefix letter: f, r, b or u in either case',
+    test: (c) => /[fFrRbBuU]/.test(c),
+  },
+];
+
+/**
+ * Emit the class bits and the table, 16 entries per row.
+ *
+ * @returns {string}
+ */
+function emitCharClasses() {
+  const lines = ['// Character classes: the bits of char_classes[]'];
+  charClasses.forEach((charClass, bit) => {
+    const value = `0x${(1 << bit).toString(16).padStart(2, '0')}`;
+    lines.push(`#define ${charClass.name} ${value}  // ${charClass.doc}`);
+  });
+  lines.push('');
+  lines.push('/**');
+  lines.push(' * CHAR_* bits of each of the first 256 code points');
+  lines.push(' */');
+  lines.push('static const uint8_t char_classes[256] = {');
+  for (let row = 0; row < 256; row += 16) {
+    const entries = [];
+    for (let code = row; code < row + 16; code++) {
+      const c = String.fromCharCode(code);
+      let bits = 0;
+      charClasses.forEach((charClass, bit) => {
+        if (code < 128 && charClass.test(c)) {
+          bits |= 1 << bit;
+        }
+      });
+      entries.push(`0x${bits.toString(16).padStart(2, '0')}`);
+    }
+    lines.push(`    ${entries.join(', ')},`);
+  }
+  lines.push('};');
+  lines.push('');
+  lines.push('/**');
+  lines.push(' * CHAR_* bits of a lookahead code point (0 past the table)');
+  lines.push(' */');
+  lines.push('static inline uint8_t char_class(int32_t c) {');
+  lines.push('    return (uint32_t)c < 256 ? char_classes[c] : 0;');
+  lines.push('}');
+  return lines.join('\n');
+}
+
+/**
+ * Read a word list: one word per line, `#` starts a comment line.
+ *
+ * @param {string} file
+ * @returns {string[]}
+ */
+function readWordList(file) {
+  const words = fs.readFileSync(path.join(root, 'src', 'wordlists', file), 'utf8')
+    .split('\n')
+    .map((line) => line.trim())
+    .filter((line) => line.length > 0 && !line.startsWith('#'));
+  const seen = new Set();
+  for (const word of words) {
+    if (seen.has(word)) {
+      throw new Error(`${file}: duplicate word '${word}'`);
+    }
+    if (!/^[\x21-\x7e]+$/.test(word)) {
+      throw new Error(`${file}: '${word}' is not printable ASCII`);
+    }
+    seen.add(word);
+  }
+  return words;
+}
+
+/**
+ * @param {string} c
+ * @returns {string}
+ */
+function charLiteral(c) {
+  return c === '\'' || c === '\\' ? `'\\${c}'` : `'${c}'`;
+}
+
+/**
+ * @param {string} s
+ * @returns {string}
+ */
+function stringLiteral(s) {
+  return `"${s.replace(/[\\"]/g, (c) => `\\${c}`)}"`;
+}
+
+/**
+ * Emit a length-bucketed switch for one word list.
+ *
+ * @param {{name: string, list: string, doc: string}} table
+ * @returns {string}
+ */
+function emitLookup(table) {
+  const words = readWordList(table.list);
+
+  /** @type {Map<number, Map<string, string[]>>} */
+  const buckets = new Map();
+  for (const word of words) {
+    if (!buckets.has(word.length)) {
+      buckets.set(word.length, new Map());
+    }
+    const byFirst = buckets.get(word.length);
+    if (!byFirst.has(word[0])) {
+      byFirst.set(word[0], []);
+    }
+    byFirst.get(word[0]).push(word);
+  }
+
+  const lines = [
+    '/**',
+    ` * ${table.doc}`,
+    ` * (${words.length} words from src/wordlists/${table.list})`,
+    ' */',
+    `static bool ${table.name}(const char *ident, size_t len) {`,
+    '    switch (len) {',
+  ];
+  for (const length of [...buckets.keys()].sort((a, b) => a - b)) {
+    lines.push(`        case ${length}:`);
+    lines.push('            switch (ident[0]) {');
+    const byFirst = buckets.get(length);
+    for (const first of [...byFirst.keys()].sort()) {
+      const candidates = byFirst.get(first).sort();
+      lines.push(`                case ${charLiteral(first)}:`);
+      if (length === 1) {
+        lines.push('                    return true;');
+        continue;
+      }
+      const tests = candidates.map((word) =>
+        `memcmp(ident + 1, ${stringLiteral(word.slice(1))}, ${length - 1}) == 0`);
+      lines.push(`                    return ${tests.join(' ||\n                           ')};`);
+    }
+    lines.push('                default:');
+    lines.push('                    return false;');
+    lines.push('            }');
+  }
+  lines.push('        default:');
+  lines.push('            return false;');
+  lines.push('    }');
+  lines.push('}');
+  return lines.join('\n');
+}
+
+function generate() {
+  return [
+    '// Generated by scripts/generate-scanner-tables.js from src/wordlists/*.txt.',
+    '// Do not edit by hand: edit the word lists or the script and run `make src/scanner_tables.h`.',
+    '',
+    '#ifndef TREE_SITTER_XONSH_SCANNER_TABLES_H_',
+    '#define TREE_SITTER_XONSH_SCANNER_TABLES_H_',
+    '',
+    '#include <stdbool.h>',
+    '#include <stddef.h>',
+    '#include <stdint.h>',
+    '#include <string.h>',
+    '',
+    emitCharClasses() + '\n',
+    ...tables.map((table) => emitLookup(table) + '\n'),
+    '#endif // TREE_SITTER_XONSH_SCANNER_TABLES_H_',
+    '',
+  ].join('\n');
+}
+
+const header = generate();
+if (process.argv.includes('--check')) {
+  const current = fs.existsSync(output) ? fs.readFileSync(output, 'utf8') : '';
+  if (current !== header) {
+    console.error(`${path.relative(root, output)} is out of date; run \`make src/scanner_tables.h\``);
+    process.exit(1);
+  }
+} else {
+  fs.writeFileSync(output, header);
+}
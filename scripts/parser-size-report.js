@@ -0,0 +1,120 @@
+#!/usr/bin/env node
+/**
+ * @file Reports how large the generated parser is
+ * @license MIT
+ *
+ * Reads the counts tree-sitter writes at the top of src/parser.c (states,
+ * large states, symbols, ...), sizes its two parse tables, counts the states
+ * of its lexer, and adds the size of the compiled src/parser.o when it exists. Every rule grammar.js adds or
+ * overrides multiplies parse states, and the tables are most of the library,
+ * of its load time and of the parser's cache footprint, so grammar changes
+ * should be checked against this.
+ *
+ * Usage:
+ *   node scripts/parser-size-report.js                     # print a table
+ *   node scripts/parser-size-report.js --json              # one JSON object
+ *   node scripts/parser-size-report.js --baseline old.json # with deltas
+ */
+
+const childProcess = require('child_process');
+const fs = require('fs');
+const path = require('path');
+
+const root = path.join(__dirname, '..');
+const parserSource = path.join(root, 'src', 'parser.c');
+const parserObject = path.join(root, 'src', 'parser.o');
+
+const defines = [
+  ['states', 'STATE_COUNT'],
+  ['large_states', 'LARGE_STATE_COUNT'],
+  ['symbols', 'SYMBOL_COUNT'],
+  ['aliases', 'ALIAS_COUNT'],
+  ['tokens', 'TOKEN_COUNT'],
+  ['external_tokens', 'EXTERNAL_TOKEN_COUNT'],
+  ['fields', 'FIELD_COUNT'],
+  ['production_ids', 'PRODUCTION_ID_COUNT'],
+];
+
+/**
+ * Number of uint16 entries in the array initializer `name` in parser.c.
+ */
+function arrayEntries(source, name) {
+  const start = source.indexOf(`${name}[] = {`);
+  if (start === -1) {
+    return 0;
+  }
+  const end = source.indexOf('\n};', start);
+  return source.slice(source.indexOf('{', start) + 1, end)
+    .split(',')
+    .filter((entry) => entry.trim() !== '')
+    .length;
+}
+
+/**
+ * Number of states of the main lexer: the `case N:` labels of ts_lex's
+ * switch in parser.c. Every regex token multiplies them.
+ */
+function lexStates(source) {
+  const start = source.indexOf('static bool ts_lex(');
+  if (start === -1) {
+    return 0;
+  }
+  const body = source.slice(start, source.indexOf('\n}\n', start));
+  return (body.match(/^ {4}case \d+:/gm) || []).length;
+}
+
+/**
+ * Section sizes of parser.o from `size`, if the tool is there.
+ */
+function objectSections(file) {
+  const result = childProcess.spawnSync('size', [file], { encoding: 'utf8' });
+  if (result.status !== 0) {
+    return {};
+  }
+  const [text, data, bss] = result.stdout.trim().split('\n')[1].trim().split(/\s+/).map(Number);
+  return { object_text_bytes: text, object_data_bytes: data, object_bss_bytes: bss };
+}
+
+function report() {
+  if (!fs.existsSync(parserSource)) {
+    console.error('src/parser.c not found: run `tree-sitter generate` first');
+    process.exit(1);
+  }
+  const source = fs.readFileSync(parserSource, 'utf8');
+  const counts = {};
+  for (const [key, define] of defines) {
+    const match = source.match(new RegExp(`#define ${define} (\\d+)`));
+    counts[key] = match ? Number(match[1]) : 0;
+  }
+  counts.small_states = counts.states - counts.large_states;
+  counts.large_table_bytes = counts.large_states * counts.symbols * 2;
+  counts.small_table_bytes = arrayEntries(source, 'ts_small_parse_table') * 2;
+  counts.lex_states = lexStates(source);
+  counts.parser_c_bytes = fs.statSync(parserSource).size;
+  if (fs.existsSync(parserObject)) {
+    counts.object_bytes = fs.statSync(parserObject).size;
+    Object.assign(counts, objectSections(parserObject));
+  }
+  return counts;
+}
+
+const args = process.argv.slice(2);
+const counts = report();
+
+if (args.includes('--json')) {
+  console.log(JSON.stringify(counts));
+} else {
+  const baselineIndex = args.indexOf('--baseline');
+  const baseline = baselineIndex !== -1
+    ? JSON.parse(fs.readFileSync(args[baselineIndex + 1], 'utf8'))
+    : null;
+  for (const [key, value] of Object.entries(counts)) {
+    let line = `${key.padEnd(20)} ${String(value).padStart(12)}`;
+    if (baseline && key in baseline && baseline[key]) {
+      const delta = value - baseline[key];
+      const percent = (100 * delta / baseline[key]).toFixed(1);
+      line += `  ${delta >= 0 ? '+' : ''}${delta} (${delta >= 0 ? '+' : ''}${percent}%)`;
+    }
+    console.log(line);
+  }
+}
@@ -1,5 +1,10 @@
-from os.path import isdir, join
+from os import environ
+from os.path import isdir, isfile, join
 from platform import system
+from shlex import split
+from subprocess import DEVNULL, CalledProcessError, check_output
+from sys import stderr, version_info
+from sysconfig import get_config_var
 
 from setuptools import Extension, find_packages, setup
 from setuptools.command.build import build
@@ -14,14 +19,57 @@ class Build(build):
         super().run()
 
 
+# Wheels use the limited API from 3.8 on, except on the free-threaded build,
+# which has none. The buffer protocol only joined it in 3.11, so 3.11 and
+# later build a cp311 abi3 wheel that parses buffers in place, and older
+# versions keep the cp38 one, which copies them.
+limited_api = not get_config_var("Py_GIL_DISABLED")
+abi3_floor = (3, 11) if version_info >= (3, 11) else (3, 8)
+
+
 class BdistWheel(bdist_wheel):
     def get_tag(self):
         python, abi, platform = super().get_tag()
-        if python.startswith("cp"):
-            python, abi = "cp38", "abi3"
+        if python.startswith("cp") and limited_api:
+            python, abi = "cp%d%d" % abi3_floor, "abi3"
         return python, abi, platform
 
 
+def runtime_flags():
+    """
+    Compiler and linker flags for the tree-sitter runtime, which parse_many()
+    needs: TS_RUNTIME_CFLAGS/TS_RUNTIME_LIBS if set, as for `make bench`, else
+    pkg-config, linking libtree-sitter.a when it has one so that a wheel does
+    not depend on a shared runtime being installed.
+    """
+    if "TS_RUNTIME_LIBS" in environ:
+        return split(environ.get("TS_RUNTIME_CFLAGS", "")), split(environ["TS_RUNTIME_LIBS"])
+    try:
+        cflags = check_output(["pkg-config", "--cflags", "tree-sitter"], stderr=DEVNULL, text=True)
+        libs = check_output(["pkg-config", "--libs", "tree-sitter"], stderr=DEVNULL, text=True)
+        libdir = check_output(["pkg-config", "--variable=libdir", "tree-sitter"], stderr=DEVNULL, text=True)
+    except (OSError, CalledProcessError):
+        return None
+    archive = join(libdir.strip(), "libtree-sitter.a")
+    if system() != "Windows" and isfile(archive):
+        return split(cflags), [archive]
+    return split(cflags), split(libs)
+
+
+runtime = runtime_flags()
+if runtime is None:
+    # Release wheels set this so that a missing runtime fails the build
+    # instead of shipping a binding whose parse_many() only raises
+    if environ.get("TREE_SITTER_XONSH_REQUIRE_RUNTIME") == "1":
+        raise SystemExit(
+            "tree-sitter-xonsh: TREE_SITTER_XONSH_REQUIRE_RUNTIME is set but no tree-sitter runtime was "
+            "found: install it where pkg-config finds it or set TS_RUNTIME_CFLAGS/TS_RUNTIME_LIBS"
+        )
+    print(
+        "tree-sitter-xonsh: no tree-sitter runtime found, building without parse_many() and parse_buffer()",
+        file=stderr,
+    )
+
 setup(
     packages=find_packages("bindings/python"),
     package_dir={"": "bindings/python"},
@@ -38,18 +86,19 @@ setup(
                 "src/parser.c",
                 "src/scanner.c"
             ],
-            extra_compile_args=[
+            extra_compile_args=([
                 "-std=c11",
             ] if system() != "Windows" else [
                 "/std:c11",
                 "/utf-8",
-            ],
+            ]) + (runtime[0] if runtime else []),
+            extra_link_args=runtime[1] if runtime else [],
             define_macros=[
-                ("Py_LIMITED_API", "0x03080000"),
                 ("PY_SSIZE_T_CLEAN", None)
-            ],
+            ] + ([("Py_LIMITED_API", "0x%02X%02X0000" % abi3_floor)] if limited_api else [])
+              + ([("TREE_SITTER_XONSH_RUNTIME", None)] if runtime else []),
             include_dirs=["src"],
-            py_limited_api=True,
+            py_limited_api=limited_api,
         )
     ],
     cmdclass={
@@ -0,0 +1,116 @@
+/**
+ * TSLexer over an in-memory UTF-8 buffer.
+ *
+ * Drives the scanner without the tree-sitter runtime: the line classifier
+ * (tree_sitter_xonsh_classify_line) runs detection over it, and benchmarks
+ * and tests use it to call scanner internals directly. It counts every
+ * advance so they can report how much lookahead a scan needed.
+ */
+
+#ifndef TREE_SITTER_XONSH_BUFFER_LEXER_H_
+#define TREE_SITTER_XONSH_BUFFER_LEXER_H_
+
+#include "tree_sitter/parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    TSLexer lexer;
+    const uint8_t *data;
+    size_t length;
+    size_t position;
+    size_t width;
+    size_t marked_end;
+    uint64_t advances;
+} BufferLexer;
+
+static void buffer_lexer__decode(BufferLexer *self) {
+    if (self->position >= self->length) {
+        self->lexer.lookahead = 0;
+        self->width = 0;
+        return;
+    }
+    const uint8_t *s = &self->data[self->position];
+    size_t remaining = self->length - self->position;
+    uint8_t c = s[0];
+    if (c < 0x80) {
+        self->lexer.lookahead = c;
+        self->width = 1;
+    } else if ((c & 0xE0) == 0xC0 && remaining >= 2) {
+        self->lexer.lookahead = ((c & 0x1F) << 6) | (s[1] & 0x3F);
+        self->width = 2;
+    } else if ((c & 0xF0) == 0xE0 && remaining >= 3) {
+        self->lexer.lookahead = ((c & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        self->width = 3;
+    } else if ((c & 0xF8) == 0xF0 && remaining >= 4) {
+        self->lexer.lookahead = ((c & 0x07) << 18) | ((s[1] & 0x3F) << 12) |
+                                ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        self->width = 4;
+    } else {
+        self->lexer.lookahead = 0xFFFD;
+        self->width = 1;
+    }
+}
+
+static void buffer_lexer__advance(TSLexer *lexer, bool skip) {
+    BufferLexer *self = (BufferLexer *)lexer;
+    (void)skip;
+    if (self->position >= self->length) {
+        return;
+    }
+    self->position += self->width;
+    self->advances++;
+    buffer_lexer__decode(self);
+}
+
+static void buffer_lexer__mark_end(TSLexer *lexer) {
+    BufferLexer *self = (BufferLexer *)lexer;
+    self->marked_end = self->position;
+}
+
+static uint32_t buffer_lexer__get_column(TSLexer *lexer) {
+    BufferLexer *self = (BufferLexer *)lexer;
+    size_t start = self->position;
+    while (start > 0 && self->data[start - 1] != '\n') {
+        start--;
+    }
+    return (uint32_t)(self->position - start);
+}
+
+static bool buffer_lexer__is_at_included_range_start(const TSLexer *lexer) {
+    (void)lexer;
+    return false;
+}
+
+static bool buffer_lexer__eof(const TSLexer *lexer) {
+    const BufferLexer *self = (const BufferLexer *)lexer;
+    return self->position >= self->length;
+}
+
+static void buffer_lexer__log(const TSLexer *lexer, const char *format, ...) {
+    (void)lexer;
+    (void)format;
+}
+
+/**
+ * Point the lexer at `data[position..length)`. The advance counter is kept,
+ * so callers can accumulate it over many scans: zero-initialize the lexer
+ * (`BufferLexer lexer = {0};`) before the first reset.
+ */
+static void buffer_lexer_reset(BufferLexer *self, const char *data, size_t length, size_t position) {
+    self->lexer.advance = buffer_lexer__advance;
+    self->lexer.mark_end = buffer_lexer__mark_end;
+    self->lexer.get_column = buffer_lexer__get_column;
+    self->lexer.is_at_included_range_start = buffer_lexer__is_at_included_range_start;
+    self->lexer.eof = buffer_lexer__eof;
+    self->lexer.log = buffer_lexer__log;
+    self->lexer.result_symbol = 0;
+    self->data = (const uint8_t *)data;
+    self->length = length;
+    self->position = position;
+    self->marked_end = position;
+    buffer_lexer__decode(self);
+}
+
+#endif // TREE_SITTER_XONSH_BUFFER_LEXER_H_
@@ -0,0 +1,283 @@
+/**
+ * Runtime registry of extra shell command names.
+ *
+ * Complements the static shell_commands list in scanner_tables.h: embedders
+ * register names (typically a snapshot of the executables on $PATH) and the
+ * scanner treats them as known commands when detecting bare subprocesses.
+ *
+ * Names are stored back to back in one byte buffer and indexed by an
+ * open-addressing hash table of 8-byte slots kept at most half full, so a
+ * lookup is one hash plus, on average, about one probe however many names
+ * are registered.
+ *
+ * The registry is process-wide, and names may be registered or cleared while
+ * other threads parse. Lookups take no lock. The slots and names live in one
+ * CommandTable published through an atomic pointer; a writer adds a name in
+ * place by filling in its bytes and then its slot with a release store, so a
+ * lookup sees either nothing or the whole name. Growing or clearing the
+ * table publishes a new one (or none), and the old one is freed once no
+ * lookup can still be reading it.
+ *
+ * Freeing needs to know when that is, and a library lookup has no quiescent
+ * point to report, so each lookup counts itself in for its duration. The
+ * counters are striped by stack address, which keeps threads on different
+ * cache lines, and come in two epochs: a writer moves new lookups to the
+ * other epoch and waits for the old one to drain, twice, so a steady stream
+ * of lookups cannot hold it off. Lookups skip all this while the registry is
+ * empty, so parsing without registered names touches nothing shared.
+ */
+
+#ifndef TREE_SITTER_XONSH_COMMAND_REGISTRY_H_
+#define TREE_SITTER_XONSH_COMMAND_REGISTRY_H_
+
+#include "tree_sitter/alloc.h"
+
+#include "scanner_atomic.h"
+#include "scanner_tables.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Longest name detection can match (it reads identifiers into a 64-byte buffer)
+#define COMMAND_REGISTRY_MAX_NAME_LENGTH 63
+
+// Lookup counters per epoch, each on its own cache line
+#define COMMAND_REGISTRY_STRIPE_BITS 4
+#define COMMAND_REGISTRY_STRIPES (1 << COMMAND_REGISTRY_STRIPE_BITS)
+
+typedef struct {
+    uint32_t hash;
+    // Offset into names << 6 | length; zero marks an empty slot. Published
+    // last, with a release store, once the hash and the name bytes are written
+    volatile uint32_t location;
+} CommandSlot;
+
+typedef struct {
+    uint32_t capacity;  // Number of slots, always a power of two
+    uint32_t count;
+    uint32_t names_size;
+    uint32_t names_capacity;
+    CommandSlot *slots;  // Both point into the same allocation, after the header
+    char *names;
+} CommandTable;
+
+typedef struct {
+    volatile uint32_t lookups;
+    char padding[60];
+} CommandLookupStripe;
+
+typedef struct {
+    CommandTable *volatile table;  // NULL while empty; replaced only under write_lock
+    volatile uint32_t count;       // Read without the lock through relaxed_load_u32
+    volatile uint32_t epoch;       // Which row of lookups new lookups count themselves in
+    ScannerSpinLock write_lock;
+    CommandLookupStripe lookups[2][COMMAND_REGISTRY_STRIPES];
+} CommandRegistry;
+
+static CommandRegistry command_registry;
+
+static inline uint32_t command_registry__hash(const char *name, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Threads' stacks lie at least a page apart, so hashing the page number of a
+// local variable spreads concurrent lookups over the stripes
+static inline uint32_t command_registry__stripe(const void *stack) {
+    return ((uint32_t)((uintptr_t)stack >> 12) * 2654435769u) >> (32 - COMMAND_REGISTRY_STRIPE_BITS);
+}
+
+static inline uint32_t command_slot_offset(uint32_t location) { return location >> 6; }
+
+static inline uint32_t command_slot_length(uint32_t location) { return location & 0x3F; }
+
+/**
+ * Find the slot holding `name`, or the empty slot where it would go, and the
+ * location seen there (zero if empty: a writer may fill the slot right after).
+ */
+static inline CommandSlot *command_table__find(const CommandTable *self, const char *name, size_t length,
+                                               uint32_t hash, uint32_t *found) {
+    uint32_t mask = self->capacity - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        CommandSlot *slot = &self->slots[i];
+        uint32_t location = acquire_load_u32(&slot->location);
+        if (location == 0 || (slot->hash == hash && command_slot_length(location) == length &&
+                              memcmp(&self->names[command_slot_offset(location)], name, length) == 0)) {
+            *found = location;
+            return slot;
+        }
+    }
+}
+
+/**
+ * Check if `name` was registered at runtime.
+ */
+static inline bool command_registry_contains(const char *name, size_t length) {
+    CommandRegistry *self = &command_registry;
+    if (relaxed_load_u32(&self->count) == 0 || length == 0 || length > COMMAND_REGISTRY_MAX_NAME_LENGTH) {
+        return false;
+    }
+    uint32_t hash = command_registry__hash(name, length);
+    uint32_t epoch = relaxed_load_u32(&self->epoch) & 1;
+    volatile uint32_t *lookups = &self->lookups[epoch][command_registry__stripe(&hash)].lookups;
+    seq_cst_add_u32(lookups, 1);
+    const CommandTable *table = seq_cst_load_ptr((void *const volatile *)&self->table);
+    uint32_t found = 0;
+    if (table != NULL) {
+        command_table__find(table, name, length, hash, &found);
+    }
+    seq_cst_add_u32(lookups, (uint32_t)-1);
+    return found != 0;
+}
+
+static inline uint32_t command_registry_count(void) { return relaxed_load_u32(&command_registry.count); }
+
+/**
+ * Wait until no lookup can still be reading a table unpublished before the
+ * call. Writers only, under write_lock.
+ */
+static void command_registry__synchronize(CommandRegistry *self) {
+    for (int flip = 0; flip < 2; flip++) {
+        uint32_t old = self->epoch & 1;
+        seq_cst_store_u32(&self->epoch, old ^ 1);
+        for (int i = 0; i < COMMAND_REGISTRY_STRIPES; i++) {
+            while (seq_cst_load_u32(&self->lookups[old][i].lookups) != 0) {
+                scanner_cpu_relax();
+            }
+        }
+    }
+}
+
+/**
+ * A table with room for `capacity` slots and `names_capacity` name bytes,
+ * holding the names of `old` (if any).
+ */
+static CommandTable *command_table_new(uint32_t capacity, uint32_t names_capacity, const CommandTable *old) {
+    CommandTable *self =
+        ts_malloc(sizeof(CommandTable) + (size_t)capacity * sizeof(CommandSlot) + names_capacity);
+    if (!self) {
+        return NULL;
+    }
+    self->capacity = capacity;
+    self->count = 0;
+    self->names_size = 0;
+    self->names_capacity = names_capacity;
+    self->slots = (CommandSlot *)(self + 1);
+    self->names = (char *)(self->slots + capacity);
+    memset(self->slots, 0, (size_t)capacity * sizeof(CommandSlot));
+    if (old) {
+        memcpy(self->names, old->names, old->names_size);
+        self->names_size = old->names_size;
+        self->count = old->count;
+        uint32_t mask = capacity - 1;
+        for (uint32_t i = 0; i < old->capacity; i++) {
+            if (old->slots[i].location != 0) {
+                uint32_t j = old->slots[i].hash & mask;
+                while (self->slots[j].location != 0) {
+                    j = (j + 1) & mask;
+                }
+                self->slots[j].hash = old->slots[i].hash;
+                self->slots[j].location = old->slots[i].location;
+            }
+        }
+    }
+    return self;
+}
+
+/**
+ * Only identifier-shaped names can ever be matched, because detection reads
+ * the command word with is_identifier_char (the same character classes).
+ */
+static inline bool command_registry__is_valid_name(const char *name, size_t length) {
+    if (length == 0 || length > COMMAND_REGISTRY_MAX_NAME_LENGTH) {
+        return false;
+    }
+    if (!(char_class((unsigned char)name[0]) & CHAR_IDENTIFIER_START)) {
+        return false;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if (!(char_class((unsigned char)name[i]) & CHAR_IDENTIFIER)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool command_registry__add(CommandRegistry *self, const char *name, size_t length) {
+    CommandTable *table = self->table;
+    uint32_t hash = command_registry__hash(name, length), found = 0;
+    if (table) {
+        command_table__find(table, name, length, hash, &found);
+        if (found != 0) {
+            return true;
+        }
+    }
+
+    uint32_t count = table ? table->count : 0;
+    uint32_t names_size = table ? table->names_size : 0;
+    if (names_size + length > (UINT32_MAX >> 6)) {
+        return false;
+    }
+    if (!table || (count + 1) * 2 > table->capacity || names_size + length > table->names_capacity) {
+        uint32_t capacity = table ? table->capacity : 64;
+        uint32_t names_capacity = table ? table->names_capacity : 512;
+        while ((count + 1) * 2 > capacity) {
+            capacity *= 2;
+        }
+        while (names_size + length > names_capacity) {
+            names_capacity *= 2;
+        }
+        CommandTable *grown = command_table_new(capacity, names_capacity, table);
+        if (!grown) {
+            return false;
+        }
+        seq_cst_store_ptr((void *volatile *)&self->table, grown);
+        if (table) {
+            command_registry__synchronize(self);
+            ts_free(table);
+        }
+        table = grown;
+    }
+
+    // Lookups may be probing this table: the slot goes live only once its name is there
+    CommandSlot *slot = command_table__find(table, name, length, hash, &found);
+    memcpy(&table->names[table->names_size], name, length);
+    slot->hash = hash;
+    release_store_u32(&slot->location, table->names_size << 6 | (uint32_t)length);
+    table->names_size += (uint32_t)length;
+    table->count++;
+    relaxed_store_u32(&self->count, table->count);
+    return true;
+}
+
+static bool command_registry_add(const char *name, size_t length) {
+    CommandRegistry *self = &command_registry;
+    if (!command_registry__is_valid_name(name, length)) {
+        return false;
+    }
+    scanner_spinlock_lock(&self->write_lock);
+    bool added = command_registry__add(self, name, length);
+    scanner_spinlock_unlock(&self->write_lock);
+    return added;
+}
+
+static void command_registry_clear(void) {
+    CommandRegistry *self = &command_registry;
+    scanner_spinlock_lock(&self->write_lock);
+    CommandTable *table = self->table;
+    if (table) {
+        seq_cst_store_ptr((void *volatile *)&self->table, NULL);
+        relaxed_store_u32(&self->count, 0);
+        command_registry__synchronize(self);
+        ts_free(table);
+    }
+    scanner_spinlock_unlock(&self->write_lock);
+}
+
+#endif // TREE_SITTER_XONSH_COMMAND_REGISTRY_H_
@@ -0,0 +1,76 @@
+/**
+ * Arrays with a few elements of storage inside the owning struct.
+ *
+ * The scanner's indent and delimiter stacks are almost always shallow, and
+ * tree-sitter restores them from serialized state constantly during parsing.
+ * An InlineArray keeps its first `N` elements in the struct itself and only
+ * touches the heap once it grows past them, so steady-state parsing does no
+ * allocation at all.
+ *
+ * The layout starts with the same `contents`/`size`/`capacity` fields as
+ * Array(T), so the read-only macros of tree_sitter/array.h (array_get,
+ * array_back, array_pop, array_clear) work unchanged. Anything that may
+ * allocate or free must go through the inline_array_* macros below instead.
+ * Because `contents` can point into the struct, an InlineArray must not be
+ * copied or moved once initialized.
+ */
+
+#ifndef TREE_SITTER_XONSH_INLINE_ARRAY_H_
+#define TREE_SITTER_XONSH_INLINE_ARRAY_H_
+
+#include "tree_sitter/array.h"
+
+#define InlineArray(T, N)  \
+    struct {               \
+        T *contents;       \
+        uint32_t size;     \
+        uint32_t capacity; \
+        T storage[N];      \
+    }
+
+/// Point the array at its inline storage, with no elements.
+#define inline_array_init(self)                                                                          \
+    ((self)->contents = (self)->storage, (self)->size = 0,                                               \
+     (self)->capacity = (uint32_t)(sizeof((self)->storage) / sizeof((self)->storage[0])))
+
+/// Make room for at least `new_capacity` elements.
+#define inline_array_reserve(self, new_capacity)                                                         \
+    ((self)->contents = _inline_array__reserve((self)->contents, (self)->storage, (self)->size,          \
+                                               &(self)->capacity, sizeof(*(self)->contents), new_capacity))
+
+/// Push a new `element` onto the end of the array.
+#define inline_array_push(self, element)                                                                 \
+    do {                                                                                                 \
+        if ((self)->size == (self)->capacity) {                                                          \
+            inline_array_reserve(self, (self)->capacity * 2);                                            \
+        }                                                                                                \
+        (self)->contents[(self)->size++] = (element);                                                    \
+    } while (0)
+
+/// Free any heap storage and go back to the inline storage, with no elements.
+#define inline_array_delete(self)                                                                        \
+    do {                                                                                                 \
+        if ((self)->contents != (self)->storage) {                                                       \
+            ts_free((self)->contents);                                                                   \
+        }                                                                                                \
+        inline_array_init(self);                                                                         \
+    } while (0)
+
+/// This is not what you're looking for, see `inline_array_reserve`.
+static inline void *_inline_array__reserve(void *contents, void *storage, uint32_t size, uint32_t *capacity,
+                                           size_t element_size, uint32_t new_capacity) {
+    if (new_capacity <= *capacity) {
+        return contents;
+    }
+    void *new_contents;
+    if (contents == storage) {
+        new_contents = ts_malloc(new_capacity * element_size);
+        memcpy(new_contents, storage, size * element_size);
+    } else {
+        new_contents = ts_realloc(contents, new_capacity * element_size);
+    }
+    *capacity = new_capacity;
+    return new_contents;
+}
+
+#endif // TREE_SITTER_XONSH_INLINE_ARRAY_H_
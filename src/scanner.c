@@ -6,16 +6,24 @@
 #include "tree_sitter/array.h"
 #include "tree_sitter/parser.h"
 
+// Keyword and shell command lookups, generated from src/wordlists/
+#include "scanner_tables.h"
+// Extra command names registered at runtime
+#include "command_registry.h"
+#include "inline_array.h"
+// TSLexer over a plain buffer, for tree_sitter_xonsh_classify_line
+#include "buffer_lexer.h"
+// Counters compiled in with TREE_SITTER_XONSH_STATS
+#include "scanner_stats.h"
+// Atomic loads and stores of state other threads may change
+#include "scanner_atomic.h"
+// Declarations of the functions below, and TreeSitterXonshLineKind
+#include "tree_sitter_xonsh_api.h"
+
 #include <assert.h>
 #include <stdint.h>
 #include <string.h>
 
-static bool is_alnum(int c) {
-    return (c >= '0' && c <= '9') ||
-           (c >= 'a' && c <= 'z') ||
-           (c >= 'A' && c <= 'Z');
-}
-
 enum TokenType {
     NEWLINE,
     INDENT,
@@ -107,18 +115,31 @@ static inline void set_end_character(Delimiter *delimiter, int32_t character) {
     }
 }
 
+// Indent and delimiter stacks deeper than this spill to the heap
+#define SCANNER_INLINE_CAPACITY 16
+
 typedef struct {
-    Array(uint16_t) indents;
-    Array(Delimiter) delimiters;
+    InlineArray(uint16_t, SCANNER_INLINE_CAPACITY) indents;
+    InlineArray(Delimiter, SCANNER_INLINE_CAPACITY) delimiters;
     bool inside_f_string;
 } Scanner;
 
-static inline void advance(TSLexer *lexer) { lexer->advance(lexer, false); }
+static inline void advance(TSLexer *lexer) {
+    lexer->advance(lexer, false);
+    STATS_ADD(STAT_SCAN_ADVANCES, 1);
+}
 
-static inline void skip(TSLexer *lexer) { lexer->advance(lexer, true); }
+static inline void skip(TSLexer *lexer) {
+    lexer->advance(lexer, true);
+    STATS_ADD(STAT_SCAN_ADVANCES, 1);
+}
 
 // Bare Subprocess Detection Heuristics
 
+// The per-character tests on the detection hot path stay range compares:
+// bench/char_class measured them faster than char_classes[] lookups there.
+// The table serves the sets that would otherwise be a chain of compares.
+
 /**
  * Check if character is valid for an identifier start
  */
@@ -148,113 +169,117 @@ static inline bool is_whitespace(int32_t c) {
 }
 
 /**
- * Python keywords that should never start a bare subprocess
+ * Check if the identifier is a known command: either in the static
+ * shell_commands list or registered at runtime
  */
-static const char *python_keywords[] = {
-    "def", "class", "if", "elif", "else", "for", "while", "try", "except",
-    "finally", "with", "import", "from", "return", "yield", "raise", "pass",
-    "break", "continue", "del", "global", "nonlocal", "assert", "lambda",
-    "async", "await", "match", "case", "type",
-    // Python keywords that start valid `keyword word` statements
-    "print", "not", "exec",
-    // Xonsh reserved words (prevent subprocess detection)
-    "xontrib",
-    NULL
-};
+static inline bool is_command_name(const char *ident, size_t len) {
+    return is_shell_command(ident, len) || command_registry_contains(ident, len);
+}
 
 /**
- * Check if the identifier matches a Python keyword
+ * Result type for subprocess detection
  */
-static bool is_python_keyword(const char *ident, size_t len) {
-    for (int i = 0; python_keywords[i] != NULL; i++) {
-        size_t kw_len = strlen(python_keywords[i]);
-        if (kw_len == len && strncmp(ident, python_keywords[i], len) == 0) {
-            return true;
-        }
-    }
-    return false;
-}
+typedef enum {
+    DETECT_NONE,              // Not a subprocess
+    DETECT_SUBPROCESS,        // Bare subprocess (ls -la, cd /tmp, etc.)
+    DETECT_SUBPROCESS_MACRO,  // Subprocess macro (echo! "Hello!")
+    DETECT_STRING,            // String literal (f"...", b"...", etc.) - already consumed prefix
+    DETECT_BLOCK_MACRO,       // Block macro (with! Context():)
+    DETECT_PATH_PREFIX,       // Path string prefix (p"...", pf"...", etc.) - already consumed prefix
+} DetectResult;
+
+#ifndef TREE_SITTER_XONSH_DETECT_BUDGET
+#define TREE_SITTER_XONSH_DETECT_BUDGET 0
+#endif
 
 /**
- * Python operator keywords that appear between identifiers in valid Python.
- * e.g., `x and y`, `x or y`, `x is y`, `x in y`, `x not in y`, `x as y`
- * When these appear after whitespace mid-line, they are NOT bare word arguments.
+ * Most characters detect_subprocess_line may inspect for one statement, or 0
+ * for no cap (the default: a cap changes how long lines parse). Callers that
+ * parse generated files with multi-kilobyte single lines may opt in; when the
+ * budget runs out detection decides as if the statement ended there, so
+ * shell signals seen so far make it a subprocess and anything else stays
+ * Python. Set from any thread while others parse, so it is only read and
+ * written atomically.
  */
-static const char *python_operator_keywords[] = {
-    "and", "or", "is", "in", "not", "as",
-    NULL
-};
+static volatile uint32_t detect_lookahead_budget = TREE_SITTER_XONSH_DETECT_BUDGET;
+
+static inline bool detect_budget_exhausted(uint32_t inspected) {
+    uint32_t budget = relaxed_load_u32(&detect_lookahead_budget);
+    return budget != 0 && inspected >= budget;
+}
 
 /**
- * Check if the identifier matches a Python operator keyword
+ * Advance during detection, counting the character against the budget.
  */
-static bool is_python_operator_keyword(const char *ident, size_t len) {
-    for (int i = 0; python_operator_keywords[i] != NULL; i++) {
-        size_t kw_len = strlen(python_operator_keywords[i]);
-        if (kw_len == len && strncmp(ident, python_operator_keywords[i], len) == 0) {
-            return true;
-        }
-    }
-    return false;
+static inline void detect_advance(TSLexer *lexer, uint32_t *inspected) {
+    lexer->advance(lexer, false);
+    (*inspected)++;
+    STATS_ADD(STAT_SCAN_ADVANCES, 1);
+    STATS_ADD(STAT_DETECT_ADVANCES, 1);
 }
 
 /**
- * Common shell commands that should be recognized as bare subprocess
- * even without flags or other shell signals
+ * State of the line scan in detect_subprocess_line.
+ *
+ * Each state fixes what the line resolves to if it ended right there.
+ * Strong Python signals (=, ==, ident(, ...) win from any state, so the scan
+ * returns as soon as it meets one instead of walking to the end of the line.
+ * No state settles a line as a subprocess: from each of them a later `== x`
+ * outside @(...) still makes it Python, and a later ` -x` a subprocess, so
+ * lines without a strong Python signal are scanned to the end of the
+ * statement.
  */
-static const char *shell_commands[] = {
-    // Core utilities
-    "cd", "ls", "pwd", "echo", "cat", "cp", "mv", "rm", "mkdir", "rmdir",
-    "touch", "chmod", "chown", "ln", "head", "tail", "less", "more",
-    // Search and text processing
-    "grep", "find", "sed", "awk", "sort", "uniq", "wc", "cut", "tr", "xargs",
-    // Build tools
-    "make", "cmake", "ninja", "gradle", "mvn", "ant", "meson",
-    // Package managers
-    "npm", "yarn", "pnpm", "pip", "pip3", "cargo", "go", "gem", "composer",
-    // Version control
-    "git", "svn", "hg", "bzr",
-    // Containers
-    "docker", "podman", "kubectl", "helm", "docker-compose",
-    // Network
-    "curl", "wget", "ssh", "scp", "rsync", "ping", "nc", "netstat",
-    // Archive
-    "tar", "zip", "unzip", "gzip", "gunzip", "xz", "bzip2",
-    // System
-    "sudo", "su", "ps", "top", "htop", "kill", "killall", "df", "du", "mount",
-    // Compilers
-    "gcc", "g++", "clang", "clang++", "rustc", "javac", "python", "python3",
-    // Editors
-    "vi", "vim", "nvim", "nano", "emacs", "code",
-    // Xonsh specific
-    "xpip", "completer", "history", "replay", "trace", "timeit",
-    NULL
-};
+typedef enum {
+    LINE_OPEN,        // No shell signal yet: Python unless something changes it
+    LINE_MACRO,       // Mid-line `ident! ` seen, Python call/subscript/attribute checks still live
+    LINE_BARE_WORDS,  // Bare word arguments seen: subprocess unless Python operators cancel them
+    LINE_SHELL,       // Flag, pipe, redirect, env arg or known command: subprocess
+} LineState;
 
 /**
- * Check if the identifier matches a known shell command
+ * Resolve a line scan that reached the end of the statement.
  */
-static bool is_shell_command(const char *ident, size_t len) {
-    for (int i = 0; shell_commands[i] != NULL; i++) {
-        size_t cmd_len = strlen(shell_commands[i]);
-        if (cmd_len == len && strncmp(ident, shell_commands[i], len) == 0) {
-            return true;
-        }
+static inline DetectResult line_state_result(LineState state, bool has_python_operator) {
+    switch (state) {
+        case LINE_MACRO:
+        case LINE_SHELL:
+            return DETECT_SUBPROCESS;
+        case LINE_BARE_WORDS:
+            // Python operator keywords and arithmetic ops cancel bare word
+            // detection, but not the stronger shell signals above
+            return has_python_operator ? DETECT_NONE : DETECT_SUBPROCESS;
+        default:
+            return DETECT_NONE;
     }
-    return false;
 }
 
 /**
- * Result type for subprocess detection
+ * Move to the state reached after a bare word argument (`cmd word`, `cmd 1`).
  */
-typedef enum {
-    DETECT_NONE,              // Not a subprocess
-    DETECT_SUBPROCESS,        // Bare subprocess (ls -la, cd /tmp, etc.)
-    DETECT_SUBPROCESS_MACRO,  // Subprocess macro (echo! "Hello!")
-    DETECT_STRING,            // String literal (f"...", b"...", etc.) - already consumed prefix
-    DETECT_BLOCK_MACRO,       // Block macro (with! Context():)
-    DETECT_PATH_PREFIX,       // Path string prefix (p"...", pf"...", etc.) - already consumed prefix
-} DetectResult;
+static inline LineState line_state_bare_word(LineState state) {
+    switch (state) {
+        case LINE_OPEN:
+            return LINE_BARE_WORDS;
+        case LINE_MACRO:
+            return LINE_SHELL;
+        default:
+            return state;
+    }
+}
+
+/**
+ * Move to the state reached after a mid-line subprocess macro (`bash -c! ...`).
+ */
+static inline LineState line_state_subprocess_macro(LineState state) {
+    switch (state) {
+        case LINE_OPEN:
+            return LINE_MACRO;
+        case LINE_BARE_WORDS:
+            return LINE_SHELL;
+        default:
+            return state;
+    }
+}
 
 /**
  * Detect if the current line appears to be a bare subprocess command
@@ -282,19 +307,22 @@ typedef enum {
  * 6. Contains Python comparison operators: ==, !=, <=, >=, :=
  *
  * This function scans ahead from the current position to analyze the line.
- * It does NOT consume tokens - it just peeks; which can get inefficient.
+ * It does NOT consume tokens - it just peeks. Strong Python signals end the
+ * scan immediately (see LineState); otherwise it runs to the end of the
+ * statement.
  *
  * The out parameter subprocess_macro_end is set if a subprocess macro is detected,
  * indicating how many characters were consumed up to and including "identifier! ".
  */
 static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_macro_end, Delimiter *string_delimiter) {
     *subprocess_macro_end = 0;
+    uint32_t inspected = 0;
     // Save original position marker
     lexer->mark_end(lexer);
 
     // Skip leading whitespace
-    while (is_whitespace(lexer->lookahead)) {
-        advance(lexer);
+    while (is_whitespace(lexer->lookahead) && !detect_budget_exhausted(inspected)) {
+        detect_advance(lexer, &inspected);
     }
 
     // Track position for subprocess macro detection
@@ -305,7 +333,7 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
         return DETECT_SUBPROCESS;  // Absolute path command
     }
     if (lexer->lookahead == '.') {
-        advance(lexer);
+        detect_advance(lexer, &inspected);
         pos++;
         if (lexer->lookahead == '/') {
             return DETECT_SUBPROCESS;  // Relative path ./cmd
@@ -313,7 +341,7 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
         // Could be float literal like .5, reset and continue
     }
     if (lexer->lookahead == '~') {
-        advance(lexer);
+        detect_advance(lexer, &inspected);
         pos++;
         if (lexer->lookahead == '/') {
             return DETECT_SUBPROCESS;  // Home path ~/cmd
@@ -322,7 +350,7 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
 
     // If starting with $, check what follows
     if (lexer->lookahead == '$') {
-        advance(lexer);
+        detect_advance(lexer, &inspected);
         pos++;
         if (lexer->lookahead == '(' || lexer->lookahead == '[') {
             // This is explicit subprocess syntax $(, $[, not bare
@@ -333,7 +361,7 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
 
     // If starting with !, check what follows
     if (lexer->lookahead == '!') {
-        advance(lexer);
+        detect_advance(lexer, &inspected);
         pos++;
         if (lexer->lookahead == '(' || lexer->lookahead == '[') {
             // This is explicit subprocess syntax !(, ![, not bare
@@ -350,13 +378,13 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
     // @identifier followed by . or ( is a Python decorator - don't treat as subprocess
     // @identifier followed by whitespace + path/command is a modified subprocess
     if (lexer->lookahead == '@') {
-        advance(lexer);
+        detect_advance(lexer, &inspected);
         pos++;
         // Check if followed by identifier
         if (is_identifier_start(lexer->lookahead)) {
             // Skip the identifier
-            while (is_identifier_char(lexer->lookahead)) {
-                advance(lexer);
+            while (is_identifier_char(lexer->lookahead) && !detect_budget_exhausted(inspected)) {
+                detect_advance(lexer, &inspected);
                 pos++;
             }
             // Check what follows the identifier
@@ -366,8 +394,8 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
             }
             if (is_whitespace(lexer->lookahead)) {
                 // Skip whitespace
-                while (is_whitespace(lexer->lookahead)) {
-                    advance(lexer);
+                while (is_whitespace(lexer->lookahead) && !detect_budget_exhausted(inspected)) {
+                    detect_advance(lexer, &inspected);
                     pos++;
                 }
                 // Check if what follows looks like a subprocess command
@@ -382,10 +410,10 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
                 if (is_identifier_start(lexer->lookahead)) {
                     while (is_identifier_char(lexer->lookahead) && cmd_len < 63) {
                         cmd[cmd_len++] = (char)lexer->lookahead;
-                        advance(lexer);
+                        detect_advance(lexer, &inspected);
                     }
                     cmd[cmd_len] = '\0';
-                    if (is_shell_command(cmd, cmd_len)) {
+                    if (is_command_name(cmd, cmd_len)) {
                         return DETECT_SUBPROCESS;  // @modifier known_command
                     }
                 }
@@ -401,14 +429,14 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
 
     // Skip any $ that might be at the start (for $VAR)
     if (lexer->lookahead == '$') {
-        advance(lexer);
+        detect_advance(lexer, &inspected);
         pos++;
     }
 
     if (is_identifier_start(lexer->lookahead)) {
         while (is_identifier_char(lexer->lookahead) && ident_len < 63) {
             first_ident[ident_len++] = (char)lexer->lookahead;
-            advance(lexer);
+            detect_advance(lexer, &inspected);
             pos++;
         }
         first_ident[ident_len] = '\0';
@@ -421,11 +449,7 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
             (lexer->lookahead == '"' || lexer->lookahead == '\'')) {
             bool is_string_prefix = true;
             for (size_t i = 0; i < ident_len && is_string_prefix; i++) {
-                char c = first_ident[i];
-                if (c != 'f' && c != 'F' && c != 'r' && c != 'R' &&
-                    c != 'b' && c != 'B' && c != 'u' && c != 'U') {
-                    is_string_prefix = false;
-                }
+                is_string_prefix = char_class(first_ident[i]) & CHAR_STRING_PREFIX;
             }
             if (is_string_prefix && string_delimiter != NULL) {
                 // Fill in the delimiter info based on prefix chars
@@ -456,13 +480,13 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
         // Check for help expression: identifier? or identifier??
         // These should NOT be treated as subprocess, let grammar handle them
         if (lexer->lookahead == '?') {
-            advance(lexer);
+            detect_advance(lexer, &inspected);
             if (lexer->lookahead == '?') {
-                advance(lexer);  // Skip second ?
+                detect_advance(lexer, &inspected);  // Skip second ?
             }
             // Check if rest of line is empty (just whitespace/newline)
-            while (is_whitespace(lexer->lookahead)) {
-                advance(lexer);
+            while (is_whitespace(lexer->lookahead) && !detect_budget_exhausted(inspected)) {
+                detect_advance(lexer, &inspected);
             }
             if (lexer->lookahead == '\n' || lexer->lookahead == '\0' || lexer->eof(lexer)) {
                 return DETECT_NONE;  // Help expression, not subprocess
@@ -479,7 +503,7 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
 
         // Check for subprocess macro: identifier! followed by space
         if (lexer->lookahead == '!') {
-            advance(lexer);
+            detect_advance(lexer, &inspected);
             pos++;
             if (is_whitespace(lexer->lookahead)) {
                 // "with!" is a block macro
@@ -487,8 +511,8 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
                     return DETECT_BLOCK_MACRO;
                 }
                 // Skip the whitespace
-                while (is_whitespace(lexer->lookahead)) {
-                    advance(lexer);
+                while (is_whitespace(lexer->lookahead) && !detect_budget_exhausted(inspected)) {
+                    detect_advance(lexer, &inspected);
                     pos++;
                 }
                 // This is a subprocess macro
@@ -501,12 +525,12 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
     // Special case: comma-only lines (aliases registered with commas)
     // e.g., aliases.register(",") then calling just ","
     if (ident_len == 0 && lexer->lookahead == ',') {
-        while (lexer->lookahead == ',') {
-            advance(lexer);
+        while (lexer->lookahead == ',' && !detect_budget_exhausted(inspected)) {
+            detect_advance(lexer, &inspected);
         }
         // Check rest of line is just whitespace
-        while (is_whitespace(lexer->lookahead)) {
-            advance(lexer);
+        while (is_whitespace(lexer->lookahead) && !detect_budget_exhausted(inspected)) {
+            detect_advance(lexer, &inspected);
         }
         if (lexer->lookahead == '\n' || lexer->lookahead == '\0' || lexer->eof(lexer)) {
             return DETECT_SUBPROCESS;  // Comma-only command
@@ -515,366 +539,321 @@ static DetectResult detect_subprocess_line(TSLexer *lexer, size_t *subprocess_ma
 
     // Check if first identifier is a known shell command
     // If so, treat subsequent file extensions (.txt) as shell args, not Python attributes
-    bool is_known_command = (ident_len > 0 && is_shell_command(first_ident, ident_len));
+    bool is_known_command = (ident_len > 0 && is_command_name(first_ident, ident_len));
 
     // Now scan the rest of the line looking for patterns
-    bool has_flag = false;          // -x, --flag
-    bool has_pipe = false;          // |
-    bool has_redirect = false;      // >, >>, <
-    bool has_assignment = false;    // = (but not ==)
-    bool has_call_parens = false;   // identifier followed immediately by (
-    bool has_subscript = false;     // identifier followed immediately by [
-    bool has_attribute = false;     // identifier followed immediately by .
-    bool has_comparison = false;    // ==, !=, <=, >=, :=
-    bool has_env_arg = false;       // identifier followed by $VAR (e.g., cd $HOME)
-    bool has_macro_call = false;    // identifier!( (xonsh function macro call)
-    bool has_subprocess_macro = false;  // identifier! (xonsh subprocess macro)
-    bool has_bare_word_arg = false;      // identifier after whitespace (not keyword)
-    bool has_python_keyword_op = false;  // 'and', 'or', 'is', etc. between idents
-    bool has_python_arith_op = false;    // +, %, ^, ~, , (clearly Python-only operators)
-    int brace_depth = 0;                 // track {} depth for comma handling
-
-    bool in_string = false;
-    char string_char = 0;
+    LineState state = is_known_command ? LINE_SHELL : LINE_OPEN;
+    bool has_python_operator = false;  // 'and', 'or', 'is', ... or +, %, ^, ~, , (cancel bare words)
+    int brace_depth = 0;               // track {} depth for comma handling
+
     bool prev_was_ident_no_space = (ident_len > 0);  // For detecting immediate follow
     bool prev_was_space = false;     // Track if we just saw whitespace
-    bool seen_shell_signal = is_known_command;  // Known commands disable Python-like detection
     bool prev_was_flag = false;      // Track if we just saw -x or --flag (for --key=value)
     int python_eval_depth = 0;       // Track nesting inside @(...) to ignore Python signals
 
     while (lexer->lookahead && lexer->lookahead != '\n') {
+        if (detect_budget_exhausted(inspected)) {
+            // Out of budget: decide as if the statement ended here
+            return line_state_result(state, has_python_operator);
+        }
         int32_t c = lexer->lookahead;
 
-        // Handle strings (don't scan inside them)
-        if (!in_string && (c == '"' || c == '\'')) {
-            in_string = true;
-            string_char = (char)c;
-            advance(lexer);
-            prev_was_ident_no_space = false;
-            continue;
-        }
-        if (in_string) {
-            if (c == '\\') {
-                advance(lexer);  // Skip escape
-                if (lexer->lookahead) advance(lexer);
+        switch (c) {
+            // Handle strings (don't scan inside them)
+            case '"':
+            case '\'':
+                detect_advance(lexer, &inspected);
+                prev_was_ident_no_space = false;
+                while (lexer->lookahead && lexer->lookahead != '\n' && !detect_budget_exhausted(inspected)) {
+                    if (lexer->lookahead == '\\') {
+                        detect_advance(lexer, &inspected);  // Skip escape
+                        if (lexer->lookahead) detect_advance(lexer, &inspected);
+                        continue;
+                    }
+                    if (lexer->lookahead == c) {
+                        detect_advance(lexer, &inspected);
+                        break;
+                    }
+                    detect_advance(lexer, &inspected);
+                }
                 continue;
-            }
-            if (c == string_char) {
-                in_string = false;
-            }
-            advance(lexer);
-            continue;
-        }
 
-        // Check for flags: -x or --flag
-        if (c == '-') {
-            advance(lexer);
-            if (lexer->lookahead == '-') {
-                // -- could be --flag or Python decrement (rare)
-                advance(lexer);
-                if (is_identifier_start(lexer->lookahead)) {
-                    has_flag = true;  // --flag pattern
-                    seen_shell_signal = true;
-                    prev_was_flag = true;  // Track for --key=value
+            // Check for flags: -x or --flag
+            case '-':
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '-') {
+                    // -- could be --flag or Python decrement (rare)
+                    detect_advance(lexer, &inspected);
+                    if (is_identifier_start(lexer->lookahead)) {
+                        state = LINE_SHELL;    // --flag pattern
+                        prev_was_flag = true;  // Track for --key=value
+                    }
+                } else if (is_identifier_start(lexer->lookahead)) {
+                    // Could be -x flag or Python subtraction
+                    state = LINE_SHELL;    // -x pattern
+                    prev_was_flag = true;  // Track for -k=value
                 }
-            } else if (is_identifier_start(lexer->lookahead)) {
-                // Could be -x flag or Python subtraction
-                has_flag = true;  // -x pattern
-                seen_shell_signal = true;
-                prev_was_flag = true;  // Track for -k=value
-            }
-            prev_was_ident_no_space = false;
-            continue;
-        }
-
-        // Check for pipe: | and logical or: ||
-        if (c == '|') {
-            advance(lexer);
-            if (lexer->lookahead == '|') {
-                // || is logical OR - shell signal
-                has_pipe = true;
-                seen_shell_signal = true;
-                advance(lexer);
-            } else if (lexer->lookahead != '=') {
-                has_pipe = true;  // Single | is shell pipe
-                seen_shell_signal = true;
-            }
-            prev_was_ident_no_space = false;
-            continue;
-        }
+                prev_was_ident_no_space = false;
+                continue;
 
-        // Check for & (background) and && (logical and)
-        if (c == '&') {
-            advance(lexer);
-            if (lexer->lookahead == '&') {
-                // && is logical AND - shell signal
-                has_pipe = true;  // Reuse flag - it's a shell signal
-                seen_shell_signal = true;
-                advance(lexer);
-            } else {
-                // Single & - could be background operator
-                // Skip any trailing whitespace to check if at end of line
-                while (is_whitespace(lexer->lookahead)) {
-                    advance(lexer);
+            // Check for pipe: | and logical or: ||
+            case '|':
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '|') {
+                    // || is logical OR - shell signal
+                    state = LINE_SHELL;
+                    detect_advance(lexer, &inspected);
+                } else if (lexer->lookahead != '=') {
+                    state = LINE_SHELL;  // Single | is shell pipe
                 }
-                if (lexer->lookahead == '\n' || lexer->lookahead == '\0' || lexer->eof(lexer)) {
-                    // & at end of line is background execution - shell signal
-                    has_pipe = true;
-                    seen_shell_signal = true;
+                prev_was_ident_no_space = false;
+                continue;
+
+            // Check for & (background) and && (logical and)
+            case '&':
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '&') {
+                    // && is logical AND - shell signal
+                    state = LINE_SHELL;
+                    detect_advance(lexer, &inspected);
+                } else {
+                    // Single & - could be background operator
+                    // Skip any trailing whitespace to check if at end of line
+                    while (is_whitespace(lexer->lookahead) && !detect_budget_exhausted(inspected)) {
+                        detect_advance(lexer, &inspected);
+                    }
+                    if (lexer->lookahead == '\n' || lexer->lookahead == '\0' || lexer->eof(lexer)) {
+                        // & at end of line is background execution - shell signal
+                        state = LINE_SHELL;
+                    }
                 }
-            }
-            prev_was_ident_no_space = false;
-            continue;
-        }
+                prev_was_ident_no_space = false;
+                continue;
 
-        // Check for redirect: >, >>, <
-        if (c == '>') {
-            advance(lexer);
-            if (lexer->lookahead == '=') {
-                has_comparison = true;  // >=
-            } else {
-                has_redirect = true;  // > or >>
-                seen_shell_signal = true;
-            }
-            prev_was_ident_no_space = false;
-            continue;
-        }
-        if (c == '<') {
-            advance(lexer);
-            if (lexer->lookahead == '=') {
-                has_comparison = true;  // <=
-            } else if (lexer->lookahead != '<') {
-                has_redirect = true;  // < (not <<)
-                seen_shell_signal = true;
-            }
-            prev_was_ident_no_space = false;
-            continue;
-        }
+            // Check for redirect: >, >>, <
+            case '>':
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '=') {
+                    return DETECT_NONE;  // >=
+                }
+                state = LINE_SHELL;  // > or >>
+                prev_was_ident_no_space = false;
+                continue;
+            case '<':
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '=') {
+                    return DETECT_NONE;  // <=
+                }
+                if (lexer->lookahead != '<') {
+                    state = LINE_SHELL;  // < (not <<)
+                }
+                prev_was_ident_no_space = false;
+                continue;
 
-        // Check for assignment vs comparison
-        if (c == '=') {
-            advance(lexer);
-            if (lexer->lookahead == '=' && python_eval_depth == 0) {
-                has_comparison = true;  // == (only if not inside @(...))
-                advance(lexer);
-                prev_was_flag = false;  // Reset after ==
-            } else if (prev_was_flag) {
+            // Check for assignment vs comparison
+            case '=':
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '=' && python_eval_depth == 0) {
+                    return DETECT_NONE;  // == (only if not inside @(...))
+                }
+                if (!prev_was_flag && python_eval_depth == 0) {
+                    return DETECT_NONE;  // Single = is Python assignment (only if not inside @(...))
+                }
                 // --key=value or -k=value is shell syntax, not Python assignment
                 // Keep prev_was_flag true for patterns like --env=FOO=bar
-                // Don't set has_assignment, continue scanning
-            } else if (python_eval_depth == 0) {
-                has_assignment = true;  // Single = is Python assignment (only if not inside @(...))
-                prev_was_flag = false;  // Reset after assignment
-            }
-            prev_was_ident_no_space = false;
-            continue;
-        }
-
-        // Check for != and :=, and macro calls (identifier!)
-        if (c == '!') {
-            advance(lexer);
-            if (lexer->lookahead == '=' && python_eval_depth == 0) {
-                has_comparison = true;  // != (only if not inside @(...))
-            } else if (prev_was_ident_no_space && lexer->lookahead == '(') {
-                // This is a function macro call: identifier!(args)
-                has_macro_call = true;
-            } else if (prev_was_ident_no_space && is_whitespace(lexer->lookahead)) {
-                // This is a subprocess macro: identifier! args
-                // e.g., echo! "Hello!", bash -c! echo {123}
-                has_subprocess_macro = true;
-            }
-            prev_was_ident_no_space = false;
-            continue;
-        }
-        if (c == ':') {
-            advance(lexer);
-            if (lexer->lookahead == '=' && python_eval_depth == 0) {
-                has_comparison = true;  // := (only if not inside @(...))
-            }
-            prev_was_ident_no_space = false;
-            continue;
-        }
+                prev_was_ident_no_space = false;
+                continue;
 
-        // Track parentheses depth when inside @(...) python evaluation
-        if (c == '(' && python_eval_depth > 0) {
-            python_eval_depth++;
-            advance(lexer);
-            prev_was_ident_no_space = false;
-            continue;
-        }
-        if (c == ')' && python_eval_depth > 0) {
-            python_eval_depth--;
-            advance(lexer);
-            prev_was_ident_no_space = false;
-            continue;
-        }
+            // Check for != and :=, and macro calls (identifier!)
+            case '!':
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '=' && python_eval_depth == 0) {
+                    return DETECT_NONE;  // != (only if not inside @(...))
+                }
+                if (prev_was_ident_no_space && lexer->lookahead == '(') {
+                    // This is a function macro call: identifier!(args)
+                    return DETECT_NONE;
+                }
+                if (prev_was_ident_no_space && is_whitespace(lexer->lookahead)) {
+                    // This is a subprocess macro: identifier! args
+                    // e.g., echo! "Hello!", bash -c! echo {123}
+                    state = line_state_subprocess_macro(state);
+                }
+                prev_was_ident_no_space = false;
+                continue;
+            case ':':
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '=' && python_eval_depth == 0) {
+                    return DETECT_NONE;  // := (only if not inside @(...))
+                }
+                prev_was_ident_no_space = false;
+                continue;
 
-        // Check for function call: identifier( (only before shell signals)
-        if (c == '(' && prev_was_ident_no_space && !seen_shell_signal) {
-            has_call_parens = true;
-            prev_was_ident_no_space = false;
-            advance(lexer);
-            continue;
-        }
+            // Track parentheses depth when inside @(...) python evaluation
+            case '(':
+                if (python_eval_depth > 0) {
+                    python_eval_depth++;
+                    detect_advance(lexer, &inspected);
+                    prev_was_ident_no_space = false;
+                    continue;
+                }
+                // Check for function call: identifier( (only before shell signals)
+                if (prev_was_ident_no_space && state < LINE_BARE_WORDS) {
+                    return DETECT_NONE;
+                }
+                break;
+            case ')':
+                if (python_eval_depth > 0) {
+                    python_eval_depth--;
+                    detect_advance(lexer, &inspected);
+                    prev_was_ident_no_space = false;
+                    continue;
+                }
+                break;
 
-        // Check for subscript: identifier[ (only before shell signals)
-        if (c == '[' && prev_was_ident_no_space && !seen_shell_signal) {
-            has_subscript = true;
-            prev_was_ident_no_space = false;
-            advance(lexer);
-            continue;
-        }
+            // Check for subscript: identifier[ (only before shell signals)
+            case '[':
+                if (prev_was_ident_no_space && state < LINE_BARE_WORDS) {
+                    return DETECT_NONE;
+                }
+                break;
 
-        // Check for attribute access: identifier. (only before shell signals)
-        // This prevents file extensions like output.txt from being detected
-        if (c == '.' && prev_was_ident_no_space && !seen_shell_signal) {
-            has_attribute = true;
-            prev_was_ident_no_space = false;
-            advance(lexer);
-            continue;
-        }
+            // Check for attribute access: identifier. (only before shell signals)
+            // This prevents file extensions like output.txt from being detected
+            case '.':
+                if (prev_was_ident_no_space && state < LINE_BARE_WORDS) {
+                    return DETECT_NONE;
+                }
+                break;
 
-        // Track if we just saw an identifier (with no space before next char)
-        if (is_identifier_start(c)) {
-            char word[64];
-            size_t word_len = 0;
-            word[word_len++] = (char)c;
-            advance(lexer);  // advance past first char (c == lexer->lookahead at loop top)
-            while (is_identifier_char(lexer->lookahead) && word_len < 63) {
-                word[word_len++] = (char)lexer->lookahead;
-                advance(lexer);
-            }
-            word[word_len] = '\0';
+            // Check for $ patterns - both env vars and subprocess operators
+            // $VAR, $(cmd), $[cmd] are all shell signals when after whitespace
+            case '$':
+                if (!prev_was_space) {
+                    break;
+                }
+                detect_advance(lexer, &inspected);
+                if (is_identifier_start(lexer->lookahead)) {
+                    // $VAR - environment variable argument
+                    state = LINE_SHELL;
+                } else if (lexer->lookahead == '(' || lexer->lookahead == '[') {
+                    // $(cmd) or $[cmd] - captured subprocess as argument
+                    state = LINE_SHELL;
+                }
+                prev_was_ident_no_space = false;
+                prev_was_space = false;
+                continue;
 
-            if (prev_was_space && brace_depth == 0) {
-                if (is_python_operator_keyword(word, word_len)) {
-                    has_python_keyword_op = true;
-                } else {
-                    has_bare_word_arg = true;
-                    seen_shell_signal = true;
+            // Check for @$( - tokenized substitution and @( - python evaluation as subprocess argument
+            case '@':
+                if (!prev_was_space) {
+                    break;
                 }
-            }
+                detect_advance(lexer, &inspected);
+                if (lexer->lookahead == '$') {
+                    detect_advance(lexer, &inspected);
+                    if (lexer->lookahead == '(') {
+                        // @$(cmd) - tokenized substitution
+                        state = LINE_SHELL;
+                    }
+                } else if (lexer->lookahead == '(') {
+                    // @(...) - python evaluation - start tracking paren depth
+                    detect_advance(lexer, &inspected);  // consume (
+                    python_eval_depth = 1;
+                    state = LINE_SHELL;
+                }
+                prev_was_ident_no_space = false;
+                prev_was_space = false;
+                continue;
 
-            prev_was_ident_no_space = true;
-            continue;
-        }
+            // Skip whitespace - this breaks the "immediate follow" pattern
+            case ' ':
+            case '\t':
+                detect_advance(lexer, &inspected);
+                prev_was_ident_no_space = false;  // Reset - next char isn't immediately after ident
+                prev_was_space = true;
+                prev_was_flag = false;  // Reset flag context on whitespace
+                continue;
 
-        // Numeric arguments after whitespace (e.g., cmd 1 2 3)
-        // In Python, `identifier number` without an operator is a SyntaxError;
-        // in subprocess context, numbers are valid arguments.
-        if (is_digit(c) && prev_was_space && brace_depth == 0) {
-            advance(lexer);
-            while (is_digit(lexer->lookahead) || lexer->lookahead == '.') {
-                advance(lexer);
-            }
-            has_bare_word_arg = true;
-            seen_shell_signal = true;
-            prev_was_ident_no_space = false;
-            prev_was_space = false;
-            continue;
-        }
+            // Semicolons are Python statement separators — stop scanning here
+            // so we only analyze the first statement on the line.
+            // Comments (#) also end the scannable portion of the line.
+            case ';':
+            case '#':
+                return line_state_result(state, has_python_operator);
 
-        // Check for $ patterns - both env vars and subprocess operators
-        // $VAR, $(cmd), $[cmd] are all shell signals when after whitespace
-        if (c == '$' && prev_was_space) {
-            advance(lexer);
-            if (is_identifier_start(lexer->lookahead)) {
-                // $VAR - environment variable argument
-                has_env_arg = true;
-                seen_shell_signal = true;
-            } else if (lexer->lookahead == '(' || lexer->lookahead == '[') {
-                // $(cmd) or $[cmd] - captured subprocess as argument
-                has_env_arg = true;  // Reuse flag - it's a shell signal
-                seen_shell_signal = true;
-            }
-            prev_was_ident_no_space = false;
-            prev_was_space = false;
-            continue;
-        }
+            // Track brace depth for comma handling
+            case '{':
+                brace_depth++;
+                break;
+            case '}':
+                if (brace_depth > 0) brace_depth--;
+                break;
 
-        // Check for @$( - tokenized substitution and @( - python evaluation as subprocess argument
-        if (c == '@' && prev_was_space) {
-            advance(lexer);
-            if (lexer->lookahead == '$') {
-                advance(lexer);
-                if (lexer->lookahead == '(') {
-                    // @$(cmd) - tokenized substitution
-                    has_env_arg = true;  // Reuse flag - it's a shell signal
-                    seen_shell_signal = true;
-                }
-            } else if (lexer->lookahead == '(') {
-                // @(...) - python evaluation - start tracking paren depth
-                advance(lexer);  // consume (
-                python_eval_depth = 1;
-                has_env_arg = true;  // This is a shell signal
-                seen_shell_signal = true;
-            }
-            prev_was_ident_no_space = false;
-            prev_was_space = false;
-            continue;
-        }
+            // Track clearly-Python arithmetic operators
+            // Commas only count at top level (not inside braces, which are brace expansion)
+            case '+':
+            case '%':
+            case '^':
+            case '~':
+                has_python_operator = true;
+                break;
+            case ',':
+                if (brace_depth == 0) has_python_operator = true;
+                break;
 
-        // Skip whitespace - this breaks the "immediate follow" pattern
-        if (is_whitespace(c)) {
-            advance(lexer);
-            prev_was_ident_no_space = false;  // Reset - next char isn't immediately after ident
-            prev_was_space = true;
-            prev_was_flag = false;  // Reset flag context on whitespace
-            continue;
-        }
+            default:
+                // Track if we just saw an identifier (with no space before next char)
+                if (is_identifier_start(c)) {
+                    char word[64];
+                    size_t word_len = 0;
+                    word[word_len++] = (char)c;
+                    detect_advance(lexer, &inspected);  // advance past first char (c == lexer->lookahead at loop top)
+                    while (is_identifier_char(lexer->lookahead) && word_len < 63) {
+                        word[word_len++] = (char)lexer->lookahead;
+                        detect_advance(lexer, &inspected);
+                    }
+                    word[word_len] = '\0';
 
-        // Semicolons are Python statement separators — stop scanning here
-        // so we only analyze the first statement on the line.
-        // Comments (#) also end the scannable portion of the line.
-        if (c == ';' || c == '#') {
-            break;
-        }
+                    if (prev_was_space && brace_depth == 0) {
+                        if (is_python_operator_keyword(word, word_len)) {
+                            has_python_operator = true;
+                        } else {
+                            state = line_state_bare_word(state);
+                        }
+                    }
 
-        // Track brace depth for comma handling
-        if (c == '{') brace_depth++;
-        if (c == '}' && brace_depth > 0) brace_depth--;
+                    prev_was_ident_no_space = true;
+                    continue;
+                }
 
-        // Track clearly-Python arithmetic operators
-        // Commas only count at top level (not inside braces, which are brace expansion)
-        if (c == '+' || c == '%' || c == '^' || c == '~' ||
-            (c == ',' && brace_depth == 0)) {
-            has_python_arith_op = true;
+                // Numeric arguments after whitespace (e.g., cmd 1 2 3)
+                // In Python, `identifier number` without an operator is a SyntaxError;
+                // in subprocess context, numbers are valid arguments.
+                if (is_digit(c) && prev_was_space && brace_depth == 0) {
+                    detect_advance(lexer, &inspected);
+                    while ((is_digit(lexer->lookahead) || lexer->lookahead == '.') &&
+                           !detect_budget_exhausted(inspected)) {
+                        detect_advance(lexer, &inspected);
+                    }
+                    state = line_state_bare_word(state);
+                    prev_was_ident_no_space = false;
+                    prev_was_space = false;
+                    continue;
+                }
+                break;
         }
 
         // Any other character (operators, punctuation, etc.)
         prev_was_ident_no_space = false;
         prev_was_space = false;
-        advance(lexer);
-    }
-
-    // Decision logic: Strong Python signals override all shell signals
-    if (has_assignment || has_comparison || has_call_parens ||
-        has_subscript || has_attribute || has_macro_call) {
-        return DETECT_NONE;  // Strong Python signals
-    }
-
-    // Python operator keywords and arithmetic ops cancel bare word detection
-    // but do NOT override strong shell signals (flags, pipes, redirects, etc.)
-    bool effective_bare_word = has_bare_word_arg &&
-        !has_python_keyword_op && !has_python_arith_op;
-
-    // Shell signals indicate subprocess
-    if (has_flag || has_pipe || has_redirect || has_env_arg ||
-        has_subprocess_macro || effective_bare_word) {
-        return DETECT_SUBPROCESS;  // Shell signals (including mid-line macro, bare word args)
-    }
-
-    // Known shell command without other signals (e.g., "make", "cd /tmp")
-    if (ident_len > 0 && is_shell_command(first_ident, ident_len)) {
-        return DETECT_SUBPROCESS;  // Known shell command
+        detect_advance(lexer, &inspected);
     }
 
-    // Default: treat as Python (safer)
-    return DETECT_NONE;
+    return line_state_result(state, has_python_operator);
 }
 
-bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, const bool *valid_symbols) {
-    Scanner *scanner = (Scanner *)payload;
+static bool scan_token(Scanner *scanner, TSLexer *lexer, const bool *valid_symbols) {
 
     bool error_recovery_mode = valid_symbols[STRING_CONTENT] && valid_symbols[INDENT];
     bool within_brackets = valid_symbols[CLOSE_BRACE] || valid_symbols[CLOSE_PAREN] || valid_symbols[CLOSE_BRACKET];
@@ -962,9 +941,12 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
                             }
                             return true;
                         }
-                        lexer->mark_end(lexer);
-                        lexer->result_symbol = STRING_CONTENT;
-                        return true;
+                    }
+                    if (lexer->lookahead) {
+                        // One or two quotes are just content: keep the token going
+                        // rather than handing the parser a token per stray quote
+                        has_content = true;
+                        continue;
                     }
                     lexer->mark_end(lexer);
                     lexer->result_symbol = STRING_CONTENT;
@@ -1020,6 +1002,20 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
             }
             if (first_comment_indent_length == -1) {
                 first_comment_indent_length = (int32_t)indent_length;
+                // A comment at or past the block's indentation rules out a
+                // DEDENT here (see below). If no INDENT, NEWLINE or operator
+                // can come out of this call either, its answer does not depend
+                // on the lines after the comment: leave the comment to the
+                // parser as an extra, instead of skipping the rest of the
+                // comment run again at the end of each of its lines.
+                bool dedent_possible =
+                    scanner->indents.size > 0 && indent_length < *array_back(&scanner->indents);
+                if (!dedent_possible && !valid_symbols[INDENT] &&
+                    !(valid_symbols[NEWLINE] && !error_recovery_mode) && !valid_symbols[LOGICAL_AND] &&
+                    !valid_symbols[LOGICAL_OR] && !valid_symbols[BACKGROUND_AMP] &&
+                    !valid_symbols[KEYWORD_AND] && !valid_symbols[KEYWORD_OR]) {
+                    return false;
+                }
             }
             while (lexer->lookahead && lexer->lookahead != '\n') {
                 skip(lexer);
@@ -1050,7 +1046,7 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
             uint16_t current_indent_length = *array_back(&scanner->indents);
 
             if (valid_symbols[INDENT] && indent_length > current_indent_length) {
-                array_push(&scanner->indents, indent_length);
+                inline_array_push(&scanner->indents, indent_length);
                 lexer->result_symbol = INDENT;
                 return true;
             }
@@ -1130,7 +1126,7 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
                 if (lexer->lookahead == 'd') {
                     advance(lexer);
                     // Check that next char is not alphanumeric (word boundary)
-                    if (!is_alnum(lexer->lookahead) && lexer->lookahead != '_') {
+                    if (!is_identifier_char(lexer->lookahead)) {
                         lexer->mark_end(lexer);
                         lexer->result_symbol = KEYWORD_AND;
                         return true;
@@ -1146,7 +1142,7 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
             if (lexer->lookahead == 'r') {
                 advance(lexer);
                 // Check that next char is not alphanumeric (word boundary)
-                if (!is_alnum(lexer->lookahead) && lexer->lookahead != '_') {
+                if (!is_identifier_char(lexer->lookahead)) {
                     lexer->mark_end(lexer);
                     lexer->result_symbol = KEYWORD_OR;
                     return true;
@@ -1180,6 +1176,8 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
         size_t subprocess_macro_end = 0;
         Delimiter string_delim = new_delimiter();
         DetectResult result = detect_subprocess_line(lexer, &subprocess_macro_end, &string_delim);
+        STATS_ADD(STAT_DETECT_CALLS, 1);
+        STATS_ADD(STAT_DETECT_RESULT_FIRST + result, 1);
 
         if (result == DETECT_BLOCK_MACRO && valid_symbols[BLOCK_MACRO_START]) {
             // Mark the token end to include "with!"
@@ -1239,12 +1237,19 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
             }
 
             if (end_character(&string_delim)) {
-                array_push(&scanner->delimiters, string_delim);
+                inline_array_push(&scanner->delimiters, string_delim);
                 lexer->result_symbol = STRING_START;
                 scanner->inside_f_string = is_format(&string_delim);
                 return true;
             }
         }
+
+        // Detection can stop anywhere on the line once the answer is fixed.
+        // Only the prefix-consumed results leave the lexer where the path and
+        // string checks below expect it.
+        if (result != DETECT_PATH_PREFIX && result != DETECT_STRING) {
+            return false;
+        }
     }
 
     // Path prefix detection: p, pf, pr, P, PF, PR immediately followed by a quote.
@@ -1325,7 +1330,7 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
         }
 
         if (end_character(&delimiter)) {
-            array_push(&scanner->delimiters, delimiter);
+            inline_array_push(&scanner->delimiters, delimiter);
             lexer->result_symbol = STRING_START;
             scanner->inside_f_string = is_format(&delimiter);
             return true;
@@ -1338,27 +1343,138 @@ bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, cons
     return false;
 }
 
-unsigned tree_sitter_xonsh_external_scanner_serialize(void *payload, char *buffer) {
-    Scanner *scanner = (Scanner *)payload;
+/*
+ * Serialized scanner state. Integers are LEB128 varints:
+ *
+ *   header           SERIALIZATION_VERSION << 1 | inside_f_string
+ *   delimiter count  number of open string delimiters
+ *   delimiter runs   flags byte, with DELIMITER_RUN_REPEAT set when a
+ *                    varint count of further identical delimiters follows
+ *   indent runs      delta << 1 | repeated, where delta is indents[i] -
+ *                    indents[i - 1] for i >= 1, followed when `repeated` is
+ *                    set by a varint count of further levels with the same
+ *                    delta; up to the end of the buffer
+ *
+ * Indents strictly increase, so deltas are small, and a block nested at a
+ * constant width costs two bytes however deep it goes. The initial state (no
+ * f-string, no delimiters, only the zero indent) serializes to no bytes.
+ */
+#define SERIALIZATION_VERSION 1
+#define DELIMITER_RUN_REPEAT 0x80
+#define VARINT_MAX_SIZE 5
+
+static inline unsigned varint_size(uint32_t value) {
+    unsigned size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static inline unsigned write_varint(char *buffer, uint32_t value) {
+    unsigned size = 0;
+    while (value >= 0x80) {
+        buffer[size++] = (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buffer[size++] = (char)value;
+    return size;
+}
+
+/**
+ * Read a varint at buffer[*size], advancing *size. Returns false if the
+ * buffer ends in the middle of it.
+ */
+static inline bool read_varint(const char *buffer, unsigned length, unsigned *size, uint32_t *value) {
+    uint32_t result = 0;
+    for (unsigned shift = 0; *size < length && shift < 7 * VARINT_MAX_SIZE; shift += 7) {
+        uint8_t byte = (uint8_t)buffer[(*size)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Number of delimiters from the bottom of the stack whose runs fit in
+ * `available` bytes.
+ */
+static uint32_t delimiters_that_fit(Scanner *scanner, unsigned available) {
+    uint32_t count = 0;
+    unsigned size = 0;
+    while (count < scanner->delimiters.size) {
+        char flags = array_get(&scanner->delimiters, count)->flags;
+        uint32_t run = 1;
+        while (count + run < scanner->delimiters.size &&
+               array_get(&scanner->delimiters, count + run)->flags == flags) {
+            run++;
+        }
+        unsigned run_size = run > 1 ? 1 + varint_size(run - 1) : 1;
+        if (size + run_size > available) {
+            break;
+        }
+        size += run_size;
+        count += run;
+    }
+    return count;
+}
 
-    size_t size = 0;
+bool tree_sitter_xonsh_external_scanner_scan(void *payload, TSLexer *lexer, const bool *valid_symbols) {
+    bool found = scan_token((Scanner *)payload, lexer, valid_symbols);
+    STATS_RECORD_SCAN(valid_symbols, found, lexer->result_symbol);
+    return found;
+}
 
-    buffer[size++] = (char)scanner->inside_f_string;
+unsigned tree_sitter_xonsh_external_scanner_serialize(void *payload, char *buffer) {
+    Scanner *scanner = (Scanner *)payload;
 
-    size_t delimiter_count = scanner->delimiters.size;
-    if (delimiter_count > UINT8_MAX) {
-        delimiter_count = UINT8_MAX;
+    if (!scanner->inside_f_string && scanner->delimiters.size == 0 && scanner->indents.size <= 1) {
+        return 0;
     }
-    buffer[size++] = (char)delimiter_count;
 
-    if (delimiter_count > 0) {
-        memcpy(&buffer[size], scanner->delimiters.contents, delimiter_count);
+    unsigned size = 0;
+    buffer[size++] = (char)(SERIALIZATION_VERSION << 1 | scanner->inside_f_string);
+
+    uint32_t delimiter_count =
+        delimiters_that_fit(scanner, TREE_SITTER_SERIALIZATION_BUFFER_SIZE - 1 - VARINT_MAX_SIZE);
+    size += write_varint(&buffer[size], delimiter_count);
+    for (uint32_t i = 0; i < delimiter_count;) {
+        char flags = array_get(&scanner->delimiters, i)->flags;
+        uint32_t run = 1;
+        while (i + run < delimiter_count && array_get(&scanner->delimiters, i + run)->flags == flags) {
+            run++;
+        }
+        if (run > 1) {
+            buffer[size++] = (char)(flags | DELIMITER_RUN_REPEAT);
+            size += write_varint(&buffer[size], run - 1);
+        } else {
+            buffer[size++] = flags;
+        }
+        i += run;
     }
-    size += delimiter_count;
 
-    uint32_t iter = 1;
-    for (; iter < scanner->indents.size && size < TREE_SITTER_SERIALIZATION_BUFFER_SIZE; ++iter) {
-        buffer[size++] = (char)*array_get(&scanner->indents, iter);
+    for (uint32_t i = 1; i < scanner->indents.size;) {
+        uint32_t delta = *array_get(&scanner->indents, i) - *array_get(&scanner->indents, i - 1);
+        uint32_t run = 1;
+        while (i + run < scanner->indents.size &&
+               (uint32_t)(*array_get(&scanner->indents, i + run) - *array_get(&scanner->indents, i + run - 1)) ==
+                   delta) {
+            run++;
+        }
+        uint32_t head = delta << 1 | (run > 1);
+        unsigned run_size = varint_size(head) + (run > 1 ? varint_size(run - 1) : 0);
+        if (size + run_size > TREE_SITTER_SERIALIZATION_BUFFER_SIZE) {
+            break;
+        }
+        size += write_varint(&buffer[size], head);
+        if (run > 1) {
+            size += write_varint(&buffer[size], run - 1);
+        }
+        i += run;
     }
 
     return size;
@@ -1367,45 +1483,248 @@ unsigned tree_sitter_xonsh_external_scanner_serialize(void *payload, char *buffe
 void tree_sitter_xonsh_external_scanner_deserialize(void *payload, const char *buffer, unsigned length) {
     Scanner *scanner = (Scanner *)payload;
 
-    array_delete(&scanner->delimiters);
-    array_delete(&scanner->indents);
-    array_push(&scanner->indents, 0);
+    // Keep whatever capacity the stacks have grown to
+    array_clear(&scanner->delimiters);
+    array_clear(&scanner->indents);
+    inline_array_push(&scanner->indents, 0);
+    scanner->inside_f_string = false;
 
-    if (length > 0) {
-        size_t size = 0;
+    if (length == 0 || (uint8_t)buffer[0] >> 1 != SERIALIZATION_VERSION) {
+        return;
+    }
 
-        scanner->inside_f_string = (bool)buffer[size++];
+    unsigned size = 0;
+    scanner->inside_f_string = buffer[size++] & 1;
 
-        size_t delimiter_count = (uint8_t)buffer[size++];
-        if (delimiter_count > 0) {
-            array_reserve(&scanner->delimiters, delimiter_count);
-            scanner->delimiters.size = delimiter_count;
-            memcpy(scanner->delimiters.contents, &buffer[size], delimiter_count);
-            size += delimiter_count;
+    uint32_t delimiter_count;
+    if (!read_varint(buffer, length, &size, &delimiter_count)) {
+        return;
+    }
+    while (scanner->delimiters.size < delimiter_count && size < length) {
+        char flags = buffer[size++];
+        uint32_t run = 1;
+        if (flags & DELIMITER_RUN_REPEAT) {
+            uint32_t repeat;
+            if (!read_varint(buffer, length, &size, &repeat)) {
+                return;
+            }
+            run += repeat;
+            flags &= ~DELIMITER_RUN_REPEAT;
         }
+        for (uint32_t i = 0; i < run && scanner->delimiters.size < delimiter_count; i++) {
+            inline_array_push(&scanner->delimiters, (Delimiter){flags});
+        }
+    }
 
-        for (; size < length; size++) {
-            array_push(&scanner->indents, (unsigned char)buffer[size]);
+    uint32_t head;
+    while (size < length && read_varint(buffer, length, &size, &head)) {
+        uint32_t repeat = 0;
+        if ((head & 1) && (!read_varint(buffer, length, &size, &repeat) || repeat >= UINT16_MAX)) {
+            return;
+        }
+        for (uint32_t i = 0; i <= repeat; i++) {
+            uint16_t indent = (uint16_t)(*array_back(&scanner->indents) + (head >> 1));
+            inline_array_push(&scanner->indents, indent);
         }
     }
 }
 
+/*
+ * Optional per-thread pool of released scanners (build with
+ * -DTREE_SITTER_XONSH_SCANNER_POOL). Tree-sitter creates a scanner for every
+ * parser that gets a language and destroys it with the parser, so services
+ * that build short-lived parsers per request churn through small blocks;
+ * with the pool, destroy parks up to TREE_SITTER_XONSH_SCANNER_POOL_SIZE
+ * scanners on the calling thread and create reuses them. Pooled scanners
+ * give back anything their stacks spilled to the heap, and
+ * tree_sitter_xonsh_scanner_pool_drain() frees the calling thread's pool
+ * (call it before a pooled thread exits).
+ */
+#ifdef TREE_SITTER_XONSH_SCANNER_POOL
+
+#ifndef TREE_SITTER_XONSH_SCANNER_POOL_SIZE
+#define TREE_SITTER_XONSH_SCANNER_POOL_SIZE 64
+#endif
+
+#if defined(_MSC_VER)
+#define SCANNER_THREAD_LOCAL __declspec(thread)
+#else
+#define SCANNER_THREAD_LOCAL _Thread_local
+#endif
+
+static SCANNER_THREAD_LOCAL Scanner *scanner_pool[TREE_SITTER_XONSH_SCANNER_POOL_SIZE];
+static SCANNER_THREAD_LOCAL uint32_t scanner_pool_size;
+
+#endif
+
 void *tree_sitter_xonsh_external_scanner_create() {
 #if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
     _Static_assert(sizeof(Delimiter) == sizeof(char), "");
+    _Static_assert(PATH_PREFIX + 1 == STATS_TOKEN_TYPES, "scanner_stats.h is missing token types");
+    _Static_assert(DETECT_PATH_PREFIX + 1 == STATS_DETECT_RESULTS, "scanner_stats.h is missing detect results");
 #else
     assert(sizeof(Delimiter) == sizeof(char));
 #endif
-    Scanner *scanner = calloc(1, sizeof(Scanner));
-    array_init(&scanner->indents);
-    array_init(&scanner->delimiters);
+    Scanner *scanner = NULL;
+#ifdef TREE_SITTER_XONSH_SCANNER_POOL
+    if (scanner_pool_size > 0) {
+        scanner = scanner_pool[--scanner_pool_size];
+    }
+#endif
+    if (!scanner) {
+        scanner = ts_calloc(1, sizeof(Scanner));
+        inline_array_init(&scanner->indents);
+        inline_array_init(&scanner->delimiters);
+    }
     tree_sitter_xonsh_external_scanner_deserialize(scanner, NULL, 0);
     return scanner;
 }
 
 void tree_sitter_xonsh_external_scanner_destroy(void *payload) {
     Scanner *scanner = (Scanner *)payload;
-    array_delete(&scanner->indents);
-    array_delete(&scanner->delimiters);
-    free(scanner);
+    inline_array_delete(&scanner->indents);
+    inline_array_delete(&scanner->delimiters);
+#ifdef TREE_SITTER_XONSH_SCANNER_POOL
+    if (scanner_pool_size < TREE_SITTER_XONSH_SCANNER_POOL_SIZE) {
+        scanner_pool[scanner_pool_size++] = scanner;
+        return;
+    }
+#endif
+    ts_free(scanner);
+}
+
+void tree_sitter_xonsh_scanner_pool_drain(void) {
+#ifdef TREE_SITTER_XONSH_SCANNER_POOL
+    while (scanner_pool_size > 0) {
+        ts_free(scanner_pool[--scanner_pool_size]);
+    }
+#endif
+}
+
+bool tree_sitter_xonsh_register_command(const char *name, size_t length) {
+    return command_registry_add(name, length);
+}
+
+void tree_sitter_xonsh_clear_commands(void) { command_registry_clear(); }
+
+size_t tree_sitter_xonsh_registered_command_count(void) { return command_registry_count(); }
+
+TreeSitterXonshLineKind tree_sitter_xonsh_classify_line(const char *line, size_t length, size_t *macro_end) {
+    if (macro_end) {
+        *macro_end = 0;
+    }
+
+    // The checks scan_token makes before it runs detection at a statement start
+    size_t start = 0;
+    while (start < length && is_whitespace((unsigned char)line[start])) {
+        start++;
+    }
+    if (start == length || line[start] == '\n' || line[start] == '\r' || line[start] == '#' || line[start] == '"' ||
+        line[start] == '\'') {
+        return TREE_SITTER_XONSH_LINE_PYTHON;
+    }
+
+    BufferLexer lexer = {0};
+    buffer_lexer_reset(&lexer, line, length, start);
+    size_t subprocess_macro_end = 0;
+    Delimiter string_delimiter = new_delimiter();
+    DetectResult result = detect_subprocess_line(&lexer.lexer, &subprocess_macro_end, &string_delimiter);
+    STATS_ADD(STAT_DETECT_CALLS, 1);
+    STATS_ADD(STAT_DETECT_RESULT_FIRST + result, 1);
+
+    switch (result) {
+        case DETECT_SUBPROCESS:
+            return TREE_SITTER_XONSH_LINE_SUBPROCESS;
+        case DETECT_SUBPROCESS_MACRO:
+        case DETECT_BLOCK_MACRO:
+            // Detection stops right after "identifier! " or "with!"
+            if (macro_end) {
+                *macro_end = lexer.position;
+            }
+            return result == DETECT_BLOCK_MACRO ? TREE_SITTER_XONSH_LINE_BLOCK_MACRO
+                                                : TREE_SITTER_XONSH_LINE_SUBPROCESS_MACRO;
+        default:
+            // Including lines that start with a string or path literal
+            return TREE_SITTER_XONSH_LINE_PYTHON;
+    }
+}
+
+uint32_t tree_sitter_xonsh_set_detect_lookahead_budget(uint32_t budget) {
+    return relaxed_exchange_u32(&detect_lookahead_budget, budget);
+}
+
+bool tree_sitter_xonsh_stats_enabled(void) {
+#ifdef TREE_SITTER_XONSH_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void tree_sitter_xonsh_stats_reset(void) {
+#ifdef TREE_SITTER_XONSH_STATS
+    seq_cst_add_u32(&stats_generation, 1);
+#endif
+}
+
+#ifdef TREE_SITTER_XONSH_STATS
+// Loops over every block counted into since the last reset
+#define STATS_FOR_EACH_BLOCK(block)                                                                    \
+    for (StatsBlock *block = acquire_load_ptr((void *const volatile *)&stats_blocks); block != NULL;  \
+         block = block->next)                                                                          \
+        if (acquire_load_u32(&block->generation) == relaxed_load_u32(&stats_generation))
+#endif
+
+size_t tree_sitter_xonsh_stats_read(uint64_t *values, size_t capacity) {
+    for (size_t i = 0; i < capacity && i < STAT_COUNT; i++) {
+        values[i] = 0;
+#ifdef TREE_SITTER_XONSH_STATS
+        STATS_FOR_EACH_BLOCK(block) {
+            values[i] += relaxed_load_u64(&block->counters[i]);
+        }
+#endif
+    }
+    return STAT_COUNT;
+}
+
+const char *tree_sitter_xonsh_stats_counter_name(size_t index) {
+    return index < STAT_COUNT ? stats_counter_names[index] : NULL;
+}
+
+size_t tree_sitter_xonsh_stats_read_valid_symbols(uint32_t *masks, uint64_t *calls, size_t capacity) {
+    size_t count = 0;
+#ifdef TREE_SITTER_XONSH_STATS
+    // Threads see mostly the same combinations: merge them, up to one table's worth
+    uint32_t merged_masks[STATS_COMBINATION_SLOTS];
+    uint64_t merged_calls[STATS_COMBINATION_SLOTS];
+    STATS_FOR_EACH_BLOCK(block) {
+        for (size_t i = 0; i < STATS_COMBINATION_SLOTS; i++) {
+            uint32_t mask = relaxed_load_u32(&block->combinations[i].valid_symbols);
+            if (mask == 0) {
+                continue;
+            }
+            size_t j = 0;
+            while (j < count && merged_masks[j] != mask) {
+                j++;
+            }
+            if (j == count) {
+                if (count == STATS_COMBINATION_SLOTS) {
+                    continue;
+                }
+                merged_masks[count] = mask;
+                merged_calls[count++] = 0;
+            }
+            merged_calls[j] += relaxed_load_u64(&block->combinations[i].calls);
+        }
+    }
+    for (size_t i = 0; i < count && i < capacity; i++) {
+        masks[i] = merged_masks[i];
+        calls[i] = merged_calls[i];
+    }
+#else
+    (void)masks;
+    (void)calls;
+    (void)capacity;
+#endif
+    return count;
 }
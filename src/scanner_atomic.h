@@ -0,0 +1,197 @@
+/**
+ * Atomic access to the scanner's process-wide state.
+ *
+ * Settings such as the detection budget may change while other threads
+ * scan. They order nothing else, so relaxed loads and stores are enough:
+ * what matters is that the value is never torn and that a scanning thread
+ * rereads it instead of caching it. GCC and Clang (wasm included) get the
+ * __atomic builtins; MSVC gets volatile access, which is atomic for aligned
+ * 32-bit values and pointers on every target it supports, plus the
+ * Interlocked intrinsics (full barriers) and explicit fences.
+ *
+ * State that changes shape, like the command registry's hash table, is
+ * published through a pointer that readers load without locking; writers
+ * serialize on a ScannerSpinLock and wait out readers before freeing (see
+ * command_registry.h). The lock spins rather than sleeps: writers are rare
+ * and it needs no threads library (the wasm build has none).
+ */
+
+#ifndef TREE_SITTER_XONSH_SCANNER_ATOMIC_H_
+#define TREE_SITTER_XONSH_SCANNER_ATOMIC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Held by at most one writer; zero-initialized means unlocked
+typedef struct {
+    volatile uint32_t held;
+} ScannerSpinLock;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+#include <intrin.h>
+
+// Orders the volatile load before it against everything after it
+#if defined(_M_ARM64)
+#define scanner__acquire_fence() __dmb(_ARM64_BARRIER_ISH)
+#define scanner_cpu_relax() __yield()
+#else
+#define scanner__acquire_fence() _ReadWriteBarrier()
+#define scanner_cpu_relax() _mm_pause()
+#endif
+
+static inline uint32_t relaxed_load_u32(const volatile uint32_t *value) { return *value; }
+
+static inline void relaxed_store_u32(volatile uint32_t *value, uint32_t desired) { *value = desired; }
+
+static inline uint32_t relaxed_exchange_u32(volatile uint32_t *value, uint32_t desired) {
+    return (uint32_t)_InterlockedExchange((volatile long *)value, (long)desired);
+}
+
+static inline uint32_t acquire_load_u32(const volatile uint32_t *value) {
+    uint32_t result = *value;
+    scanner__acquire_fence();
+    return result;
+}
+
+static inline void release_store_u32(volatile uint32_t *value, uint32_t desired) {
+    _InterlockedExchange((volatile long *)value, (long)desired);
+}
+
+static inline uint32_t seq_cst_load_u32(const volatile uint32_t *value) {
+    return (uint32_t)_InterlockedOr((volatile long *)value, 0);
+}
+
+static inline void seq_cst_store_u32(volatile uint32_t *value, uint32_t desired) {
+    _InterlockedExchange((volatile long *)value, (long)desired);
+}
+
+static inline void seq_cst_add_u32(volatile uint32_t *value, uint32_t delta) {
+    _InterlockedExchangeAdd((volatile long *)value, (long)delta);
+}
+
+// Readers call this right after seq_cst_add_u32, whose full barrier it relies on
+static inline void *seq_cst_load_ptr(void *const volatile *value) {
+    void *result = *value;
+    scanner__acquire_fence();
+    return result;
+}
+
+static inline void seq_cst_store_ptr(void *volatile *value, void *desired) {
+    _InterlockedExchangePointer(value, desired);
+}
+
+static inline bool scanner_spinlock__try_lock(ScannerSpinLock *self) {
+    return _InterlockedExchange((volatile long *)&self->held, 1) == 0;
+}
+
+static inline uint64_t relaxed_load_u64(const volatile uint64_t *value) {
+#ifdef _WIN64
+    return *value;
+#else
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)value, 0, 0);
+#endif
+}
+
+static inline void relaxed_store_u64(volatile uint64_t *value, uint64_t desired) {
+#ifdef _WIN64
+    *value = desired;
+#else
+    _InterlockedExchange64((volatile __int64 *)value, (__int64)desired);
+#endif
+}
+
+static inline void *acquire_load_ptr(void *const volatile *value) {
+    void *result = *value;
+    scanner__acquire_fence();
+    return result;
+}
+
+static inline bool release_compare_exchange_ptr(void *volatile *value, void *expected, void *desired) {
+    return _InterlockedCompareExchangePointer(value, desired, expected) == expected;
+}
+
+#else
+
+#if defined(__i386__) || defined(__x86_64__)
+#define scanner_cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define scanner_cpu_relax() __asm__ __volatile__("yield")
+#else
+#define scanner_cpu_relax() ((void)0)
+#endif
+
+static inline uint32_t relaxed_load_u32(const volatile uint32_t *value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+static inline void relaxed_store_u32(volatile uint32_t *value, uint32_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t relaxed_exchange_u32(volatile uint32_t *value, uint32_t desired) {
+    return __atomic_exchange_n(value, desired, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t acquire_load_u32(const volatile uint32_t *value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline void release_store_u32(volatile uint32_t *value, uint32_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t seq_cst_load_u32(const volatile uint32_t *value) {
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+
+static inline void seq_cst_store_u32(volatile uint32_t *value, uint32_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_SEQ_CST);
+}
+
+static inline void seq_cst_add_u32(volatile uint32_t *value, uint32_t delta) {
+    __atomic_fetch_add(value, delta, __ATOMIC_SEQ_CST);
+}
+
+static inline void *seq_cst_load_ptr(void *const volatile *value) {
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+
+static inline void seq_cst_store_ptr(void *volatile *value, void *desired) {
+    __atomic_store_n(value, desired, __ATOMIC_SEQ_CST);
+}
+
+static inline bool scanner_spinlock__try_lock(ScannerSpinLock *self) {
+    return __atomic_exchange_n(&self->held, 1, __ATOMIC_ACQUIRE) == 0;
+}
+
+static inline uint64_t relaxed_load_u64(const volatile uint64_t *value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+static inline void relaxed_store_u64(volatile uint64_t *value, uint64_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELAXED);
+}
+
+static inline void *acquire_load_ptr(void *const volatile *value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline bool release_compare_exchange_ptr(void *volatile *value, void *expected, void *desired) {
+    return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+#endif
+
+// Test and test-and-set: waiters spin on a shared read, not on the exchange
+static inline void scanner_spinlock_lock(ScannerSpinLock *self) {
+    while (!scanner_spinlock__try_lock(self)) {
+        while (relaxed_load_u32(&self->held)) {
+            scanner_cpu_relax();
+        }
+    }
+}
+
+static inline void scanner_spinlock_unlock(ScannerSpinLock *self) { release_store_u32(&self->held, 0); }
+
+#endif // TREE_SITTER_XONSH_SCANNER_ATOMIC_H_
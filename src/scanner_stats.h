@@ -0,0 +1,205 @@
+/**
+ * Optional scanner instrumentation.
+ *
+ * Built with -DTREE_SITTER_XONSH_STATS, the scanner counts its calls, the
+ * characters it advances over, the tokens it emits, how much bare subprocess
+ * detection looks ahead and what it decides, and which valid_symbols
+ * combinations tree-sitter asks for.
+ * Without the flag every STATS_* macro expands to nothing.
+ *
+ * Each thread counts into its own StatsBlock, allocated on its first count
+ * and kept for the life of the process, so parses on many threads neither
+ * share a cache line nor lose increments: only the owning thread writes a
+ * block, with relaxed atomic stores, and readers sum every block with
+ * relaxed loads. A reset bumps a generation number rather than writing to
+ * other threads' blocks; each thread zeroes its own block when it next
+ * counts, and readers skip blocks from an older generation. They are read
+ * through tree_sitter_xonsh_stats_* in scanner.c.
+ */
+
+#ifndef TREE_SITTER_XONSH_SCANNER_STATS_H_
+#define TREE_SITTER_XONSH_SCANNER_STATS_H_
+
+#include "scanner_atomic.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// External tokens, in grammar.js `externals` order
+#define STATS_TOKEN_TYPES 21
+// DetectResult values
+#define STATS_DETECT_RESULTS 6
+// Distinct valid_symbols combinations tracked; more are only counted in total
+#define STATS_COMBINATION_SLOTS 128
+
+typedef enum {
+    STAT_SCAN_CALLS,
+    STAT_SCAN_NO_TOKEN,
+    STAT_SCAN_ADVANCES,
+    STAT_TOKEN_FIRST,
+    STAT_DETECT_CALLS = STAT_TOKEN_FIRST + STATS_TOKEN_TYPES,
+    STAT_DETECT_ADVANCES,
+    STAT_DETECT_RESULT_FIRST,
+    STAT_COMBINATION_OVERFLOW = STAT_DETECT_RESULT_FIRST + STATS_DETECT_RESULTS,
+    STAT_COUNT,
+} StatCounter;
+
+static const char *const stats_counter_names[STAT_COUNT] = {
+    "scan_calls",
+    "scan_no_token",
+    "scan_advances",
+    "token.newline",
+    "token.indent",
+    "token.dedent",
+    "token.string_start",
+    "token.string_content",
+    "token.escape_interpolation",
+    "token.string_end",
+    "token.comment",
+    "token.close_paren",
+    "token.close_bracket",
+    "token.close_brace",
+    "token.except",
+    "token.subprocess_start",
+    "token.logical_and",
+    "token.logical_or",
+    "token.background_amp",
+    "token.keyword_and",
+    "token.keyword_or",
+    "token.subprocess_macro_start",
+    "token.block_macro_start",
+    "token.path_prefix",
+    "detect_calls",
+    "detect_advances",
+    "detect_result.none",
+    "detect_result.subprocess",
+    "detect_result.subprocess_macro",
+    "detect_result.string",
+    "detect_result.block_macro",
+    "detect_result.path_prefix",
+    "valid_symbols_overflow",
+};
+
+#ifdef TREE_SITTER_XONSH_STATS
+
+#include "tree_sitter/alloc.h"
+
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define STATS_THREAD_LOCAL __declspec(thread)
+#else
+#define STATS_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct {
+    volatile uint32_t valid_symbols;  // Bit i set when token type i was valid; 0 marks an empty slot
+    volatile uint64_t calls;
+} StatsCombination;
+
+typedef struct StatsBlock {
+    volatile uint64_t counters[STAT_COUNT];
+    StatsCombination combinations[STATS_COMBINATION_SLOTS];
+    uint32_t combination_count;     // Only the owner reads it
+    volatile uint32_t generation;  // stats_generation when the block was last zeroed
+    struct StatsBlock *next;
+} StatsBlock;
+
+// Every thread's block, newest first; blocks are only ever pushed
+static StatsBlock *volatile stats_blocks;
+static volatile uint32_t stats_generation;
+static STATS_THREAD_LOCAL StatsBlock *stats_thread_block;
+
+static inline void stats_block__zero(StatsBlock *self) {
+    for (uint32_t i = 0; i < STAT_COUNT; i++) {
+        relaxed_store_u64(&self->counters[i], 0);
+    }
+    for (uint32_t i = 0; i < STATS_COMBINATION_SLOTS; i++) {
+        relaxed_store_u32(&self->combinations[i].valid_symbols, 0);
+        relaxed_store_u64(&self->combinations[i].calls, 0);
+    }
+    self->combination_count = 0;
+}
+
+static StatsBlock *stats_block__attach(void) {
+    StatsBlock *self = ts_calloc(1, sizeof(StatsBlock));
+    if (!self) {
+        return NULL;
+    }
+    self->generation = relaxed_load_u32(&stats_generation);
+    do {
+        self->next = acquire_load_ptr((void *const volatile *)&stats_blocks);
+    } while (!release_compare_exchange_ptr((void *volatile *)&stats_blocks, self->next, self));
+    stats_thread_block = self;
+    return self;
+}
+
+// This thread's block, zeroed if a reset happened since it last counted; NULL if out of memory
+static inline StatsBlock *stats_block(void) {
+    StatsBlock *self = stats_thread_block;
+    if (!self) {
+        return stats_block__attach();
+    }
+    uint32_t generation = relaxed_load_u32(&stats_generation);
+    if (self->generation != generation) {
+        stats_block__zero(self);
+        release_store_u32(&self->generation, generation);
+    }
+    return self;
+}
+
+static inline void stats_add(StatsBlock *self, uint32_t counter, uint64_t amount) {
+    if (self) {
+        relaxed_store_u64(&self->counters[counter], self->counters[counter] + amount);
+    }
+}
+
+#define STATS_ADD(counter, amount) stats_add(stats_block(), counter, amount)
+
+static inline void stats_record_scan(const bool *valid_symbols, bool found, uint16_t symbol) {
+    StatsBlock *self = stats_block();
+    if (!self) {
+        return;
+    }
+    stats_add(self, STAT_SCAN_CALLS, 1);
+    stats_add(self, found ? STAT_TOKEN_FIRST + symbol : STAT_SCAN_NO_TOKEN, 1);
+
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < STATS_TOKEN_TYPES; i++) {
+        mask |= (uint32_t)valid_symbols[i] << i;
+    }
+    if (mask == 0) {
+        return;
+    }
+    // Open addressing over a fixed table, keyed by the mask
+    uint32_t start = (mask * 2654435761u) % STATS_COMBINATION_SLOTS;
+    for (uint32_t i = 0; i < STATS_COMBINATION_SLOTS; i++) {
+        StatsCombination *slot = &self->combinations[(start + i) % STATS_COMBINATION_SLOTS];
+        if (slot->valid_symbols == mask) {
+            relaxed_store_u64(&slot->calls, slot->calls + 1);
+            return;
+        }
+        if (slot->valid_symbols == 0) {
+            if (self->combination_count * 4 >= STATS_COMBINATION_SLOTS * 3) {
+                break;
+            }
+            relaxed_store_u64(&slot->calls, 1);
+            relaxed_store_u32(&slot->valid_symbols, mask);
+            self->combination_count++;
+            return;
+        }
+    }
+    stats_add(self, STAT_COMBINATION_OVERFLOW, 1);
+}
+
+#define STATS_RECORD_SCAN(valid_symbols, found, symbol) stats_record_scan(valid_symbols, found, symbol)
+
+#else
+
+#define STATS_ADD(counter, amount) ((void)0)
+#define STATS_RECORD_SCAN(valid_symbols, found, symbol) ((void)0)
+
+#endif
+
+#endif // TREE_SITTER_XONSH_SCANNER_STATS_H_
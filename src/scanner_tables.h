@@ -0,0 +1,404 @@
+// Generated by scripts/generate-scanner-tables.js from src/wordlists/*.txt.
+// Do not edit by hand: edit the word lists or the script and run `make src/scanner_tables.h`.
+
+#ifndef TREE_SITTER_XONSH_SCANNER_TABLES_H_
+#define TREE_SITTER_XONSH_SCANNER_TABLES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Character classes: the bits of char_classes[]
+#define CHAR_IDENTIFIER_START 0x01  // a-z, A-Z or _
+#define CHAR_IDENTIFIER 0x02  // Identifier start or digit
+#define CHAR_STRING_PREFIX 0x04  // String prefix letter: f, r, b or u in either case
+
+/**
+ * CHAR_* bits of each of the first 256 code points
+ */
+static const uint8_t char_classes[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x07, 0x03, 0x03, 0x03, 0x07, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03,
+    0x03, 0x03, 0x07, 0x03, 0x03, 0x07, 0x03, 0x03, 0x03, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x03,
+    0x00, 0x03, 0x07, 0x03, 0x03, 0x03, 0x07, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03,
+    0x03, 0x03, 0x07, 0x03, 0x03, 0x07, 0x03, 0x03, 0x03, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/**
+ * CHAR_* bits of a lookahead code point (0 past the table)
+ */
+static inline uint8_t char_class(int32_t c) {
+    return (uint32_t)c < 256 ? char_classes[c] : 0;
+}
+
+/**
+ * Check if the identifier matches a Python keyword
+ * (33 words from src/wordlists/python_keywords.txt)
+ */
+static bool is_python_keyword(const char *ident, size_t len) {
+    switch (len) {
+        case 2:
+            switch (ident[0]) {
+                case 'i':
+                    return memcmp(ident + 1, "f", 1) == 0;
+                default:
+                    return false;
+            }
+        case 3:
+            switch (ident[0]) {
+                case 'd':
+                    return memcmp(ident + 1, "ef", 2) == 0 ||
+                           memcmp(ident + 1, "el", 2) == 0;
+                case 'f':
+                    return memcmp(ident + 1, "or", 2) == 0;
+                case 'n':
+                    return memcmp(ident + 1, "ot", 2) == 0;
+                case 't':
+                    return memcmp(ident + 1, "ry", 2) == 0;
+                default:
+                    return false;
+            }
+        case 4:
+            switch (ident[0]) {
+                case 'c':
+                    return memcmp(ident + 1, "ase", 3) == 0;
+                case 'e':
+                    return memcmp(ident + 1, "lif", 3) == 0 ||
+                           memcmp(ident + 1, "lse", 3) == 0 ||
+                           memcmp(ident + 1, "xec", 3) == 0;
+                case 'f':
+                    return memcmp(ident + 1, "rom", 3) == 0;
+                case 'p':
+                    return memcmp(ident + 1, "ass", 3) == 0;
+                case 't':
+                    return memcmp(ident + 1, "ype", 3) == 0;
+                case 'w':
+                    return memcmp(ident + 1, "ith", 3) == 0;
+                default:
+                    return false;
+            }
+        case 5:
+            switch (ident[0]) {
+                case 'a':
+                    return memcmp(ident + 1, "sync", 4) == 0 ||
+                           memcmp(ident + 1, "wait", 4) == 0;
+                case 'b':
+                    return memcmp(ident + 1, "reak", 4) == 0;
+                case 'c':
+                    return memcmp(ident + 1, "lass", 4) == 0;
+                case 'm':
+                    return memcmp(ident + 1, "atch", 4) == 0;
+                case 'p':
+                    return memcmp(ident + 1, "rint", 4) == 0;
+                case 'r':
+                    return memcmp(ident + 1, "aise", 4) == 0;
+                case 'w':
+                    return memcmp(ident + 1, "hile", 4) == 0;
+                case 'y':
+                    return memcmp(ident + 1, "ield", 4) == 0;
+                default:
+                    return false;
+            }
+        case 6:
+            switch (ident[0]) {
+                case 'a':
+                    return memcmp(ident + 1, "ssert", 5) == 0;
+                case 'e':
+                    return memcmp(ident + 1, "xcept", 5) == 0;
+                case 'g':
+                    return memcmp(ident + 1, "lobal", 5) == 0;
+                case 'i':
+                    return memcmp(ident + 1, "mport", 5) == 0;
+                case 'l':
+                    return memcmp(ident + 1, "ambda", 5) == 0;
+                case 'r':
+                    return memcmp(ident + 1, "eturn", 5) == 0;
+                default:
+                    return false;
+            }
+        case 7:
+            switch (ident[0]) {
+                case 'f':
+                    return memcmp(ident + 1, "inally", 6) == 0;
+                case 'x':
+                    return memcmp(ident + 1, "ontrib", 6) == 0;
+                default:
+                    return false;
+            }
+        case 8:
+            switch (ident[0]) {
+                case 'c':
+                    return memcmp(ident + 1, "ontinue", 7) == 0;
+                case 'n':
+                    return memcmp(ident + 1, "onlocal", 7) == 0;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+/**
+ * Check if the identifier matches a Python operator keyword
+ * (6 words from src/wordlists/python_operator_keywords.txt)
+ */
+static bool is_python_operator_keyword(const char *ident, size_t len) {
+    switch (len) {
+        case 2:
+            switch (ident[0]) {
+                case 'a':
+                    return memcmp(ident + 1, "s", 1) == 0;
+                case 'i':
+                    return memcmp(ident + 1, "n", 1) == 0 ||
+                           memcmp(ident + 1, "s", 1) == 0;
+                case 'o':
+                    return memcmp(ident + 1, "r", 1) == 0;
+                default:
+                    return false;
+            }
+        case 3:
+            switch (ident[0]) {
+                case 'a':
+                    return memcmp(ident + 1, "nd", 2) == 0;
+                case 'n':
+                    return memcmp(ident + 1, "ot", 2) == 0;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+/**
+ * Check if the identifier matches a known shell command
+ * (98 words from src/wordlists/shell_commands.txt)
+ */
+static bool is_shell_command(const char *ident, size_t len) {
+    switch (len) {
+        case 2:
+            switch (ident[0]) {
+                case 'c':
+                    return memcmp(ident + 1, "d", 1) == 0 ||
+                           memcmp(ident + 1, "p", 1) == 0;
+                case 'd':
+                    return memcmp(ident + 1, "f", 1) == 0 ||
+                           memcmp(ident + 1, "u", 1) == 0;
+                case 'g':
+                    return memcmp(ident + 1, "o", 1) == 0;
+                case 'h':
+                    return memcmp(ident + 1, "g", 1) == 0;
+                case 'l':
+                    return memcmp(ident + 1, "n", 1) == 0 ||
+                           memcmp(ident + 1, "s", 1) == 0;
+                case 'm':
+                    return memcmp(ident + 1, "v", 1) == 0;
+                case 'n':
+                    return memcmp(ident + 1, "c", 1) == 0;
+                case 'p':
+                    return memcmp(ident + 1, "s", 1) == 0;
+                case 'r':
+                    return memcmp(ident + 1, "m", 1) == 0;
+                case 's':
+                    return memcmp(ident + 1, "u", 1) == 0;
+                case 't':
+                    return memcmp(ident + 1, "r", 1) == 0;
+                case 'v':
+                    return memcmp(ident + 1, "i", 1) == 0;
+                case 'w':
+                    return memcmp(ident + 1, "c", 1) == 0;
+                case 'x':
+                    return memcmp(ident + 1, "z", 1) == 0;
+                default:
+                    return false;
+            }
+        case 3:
+            switch (ident[0]) {
+                case 'a':
+                    return memcmp(ident + 1, "nt", 2) == 0 ||
+                           memcmp(ident + 1, "wk", 2) == 0;
+                case 'b':
+                    return memcmp(ident + 1, "zr", 2) == 0;
+                case 'c':
+                    return memcmp(ident + 1, "at", 2) == 0 ||
+                           memcmp(ident + 1, "ut", 2) == 0;
+                case 'g':
+                    return memcmp(ident + 1, "++", 2) == 0 ||
+                           memcmp(ident + 1, "cc", 2) == 0 ||
+                           memcmp(ident + 1, "em", 2) == 0 ||
+                           memcmp(ident + 1, "it", 2) == 0;
+                case 'm':
+                    return memcmp(ident + 1, "vn", 2) == 0;
+                case 'n':
+                    return memcmp(ident + 1, "pm", 2) == 0;
+                case 'p':
+                    return memcmp(ident + 1, "ip", 2) == 0 ||
+                           memcmp(ident + 1, "wd", 2) == 0;
+                case 's':
+                    return memcmp(ident + 1, "cp", 2) == 0 ||
+                           memcmp(ident + 1, "ed", 2) == 0 ||
+                           memcmp(ident + 1, "sh", 2) == 0 ||
+                           memcmp(ident + 1, "vn", 2) == 0;
+                case 't':
+                    return memcmp(ident + 1, "ar", 2) == 0 ||
+                           memcmp(ident + 1, "op", 2) == 0;
+                case 'v':
+                    return memcmp(ident + 1, "im", 2) == 0;
+                case 'z':
+                    return memcmp(ident + 1, "ip", 2) == 0;
+                default:
+                    return false;
+            }
+        case 4:
+            switch (ident[0]) {
+                case 'c':
+                    return memcmp(ident + 1, "ode", 3) == 0 ||
+                           memcmp(ident + 1, "url", 3) == 0;
+                case 'e':
+                    return memcmp(ident + 1, "cho", 3) == 0;
+                case 'f':
+                    return memcmp(ident + 1, "ind", 3) == 0;
+                case 'g':
+                    return memcmp(ident + 1, "rep", 3) == 0 ||
+                           memcmp(ident + 1, "zip", 3) == 0;
+                case 'h':
+                    return memcmp(ident + 1, "ead", 3) == 0 ||
+                           memcmp(ident + 1, "elm", 3) == 0 ||
+                           memcmp(ident + 1, "top", 3) == 0;
+                case 'k':
+                    return memcmp(ident + 1, "ill", 3) == 0;
+                case 'l':
+                    return memcmp(ident + 1, "ess", 3) == 0;
+                case 'm':
+                    return memcmp(ident + 1, "ake", 3) == 0 ||
+                           memcmp(ident + 1, "ore", 3) == 0;
+                case 'n':
+                    return memcmp(ident + 1, "ano", 3) == 0 ||
+                           memcmp(ident + 1, "vim", 3) == 0;
+                case 'p':
+                    return memcmp(ident + 1, "ing", 3) == 0 ||
+                           memcmp(ident + 1, "ip3", 3) == 0 ||
+                           memcmp(ident + 1, "npm", 3) == 0;
+                case 's':
+                    return memcmp(ident + 1, "ort", 3) == 0 ||
+                           memcmp(ident + 1, "udo", 3) == 0;
+                case 't':
+                    return memcmp(ident + 1, "ail", 3) == 0;
+                case 'u':
+                    return memcmp(ident + 1, "niq", 3) == 0;
+                case 'w':
+                    return memcmp(ident + 1, "get", 3) == 0;
+                case 'x':
+                    return memcmp(ident + 1, "pip", 3) == 0;
+                case 'y':
+                    return memcmp(ident + 1, "arn", 3) == 0;
+                default:
+                    return false;
+            }
+        case 5:
+            switch (ident[0]) {
+                case 'b':
+                    return memcmp(ident + 1, "zip2", 4) == 0;
+                case 'c':
+                    return memcmp(ident + 1, "argo", 4) == 0 ||
+                           memcmp(ident + 1, "hmod", 4) == 0 ||
+                           memcmp(ident + 1, "hown", 4) == 0 ||
+                           memcmp(ident + 1, "lang", 4) == 0 ||
+                           memcmp(ident + 1, "make", 4) == 0;
+                case 'e':
+                    return memcmp(ident + 1, "macs", 4) == 0;
+                case 'j':
+                    return memcmp(ident + 1, "avac", 4) == 0;
+                case 'm':
+                    return memcmp(ident + 1, "eson", 4) == 0 ||
+                           memcmp(ident + 1, "kdir", 4) == 0 ||
+                           memcmp(ident + 1, "ount", 4) == 0;
+                case 'n':
+                    return memcmp(ident + 1, "inja", 4) == 0;
+                case 'r':
+                    return memcmp(ident + 1, "mdir", 4) == 0 ||
+                           memcmp(ident + 1, "sync", 4) == 0 ||
+                           memcmp(ident + 1, "ustc", 4) == 0;
+                case 't':
+                    return memcmp(ident + 1, "ouch", 4) == 0 ||
+                           memcmp(ident + 1, "race", 4) == 0;
+                case 'u':
+                    return memcmp(ident + 1, "nzip", 4) == 0;
+                case 'x':
+                    return memcmp(ident + 1, "args", 4) == 0;
+                default:
+                    return false;
+            }
+        case 6:
+            switch (ident[0]) {
+                case 'd':
+                    return memcmp(ident + 1, "ocker", 5) == 0;
+                case 'g':
+                    return memcmp(ident + 1, "radle", 5) == 0 ||
+                           memcmp(ident + 1, "unzip", 5) == 0;
+                case 'p':
+                    return memcmp(ident + 1, "odman", 5) == 0 ||
+                           memcmp(ident + 1, "ython", 5) == 0;
+                case 'r':
+                    return memcmp(ident + 1, "eplay", 5) == 0;
+                case 't':
+                    return memcmp(ident + 1, "imeit", 5) == 0;
+                default:
+                    return false;
+            }
+        case 7:
+            switch (ident[0]) {
+                case 'c':
+                    return memcmp(ident + 1, "lang++", 6) == 0;
+                case 'h':
+                    return memcmp(ident + 1, "istory", 6) == 0;
+                case 'k':
+                    return memcmp(ident + 1, "illall", 6) == 0 ||
+                           memcmp(ident + 1, "ubectl", 6) == 0;
+                case 'n':
+                    return memcmp(ident + 1, "etstat", 6) == 0;
+                case 'p':
+                    return memcmp(ident + 1, "ython3", 6) == 0;
+                default:
+                    return false;
+            }
+        case 8:
+            switch (ident[0]) {
+                case 'c':
+                    return memcmp(ident + 1, "omposer", 7) == 0;
+                default:
+                    return false;
+            }
+        case 9:
+            switch (ident[0]) {
+                case 'c':
+                    return memcmp(ident + 1, "ompleter", 8) == 0;
+                default:
+                    return false;
+            }
+        case 14:
+            switch (ident[0]) {
+                case 'd':
+                    return memcmp(ident + 1, "ocker-compose", 13) == 0;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+#endif // TREE_SITTER_XONSH_SCANNER_TABLES_H_
@@ -0,0 +1,137 @@
+/**
+ * Functions the external scanner exports next to the generated parser.
+ *
+ * scanner.c defines them and checks its definitions against this header;
+ * bindings/c/tree-sitter-xonsh.h includes it to make them part of the
+ * public C API, and installs it next to itself.
+ */
+
+#ifndef TREE_SITTER_XONSH_API_H_
+#define TREE_SITTER_XONSH_API_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Register an extra command name, so that lines starting with it parse as
+ * bare subprocesses even without flags, pipes or other shell signals.
+ *
+ * `name` is `length` bytes, not necessarily NUL-terminated. Only
+ * identifier-shaped names of at most 63 bytes can start a bare subprocess;
+ * anything else is rejected and the function returns false. Registering a
+ * name twice is harmless. Python keywords still win over registered names.
+ *
+ * The registry is process-wide and safe to change while other threads parse
+ * or classify lines. A parse that runs meanwhile may see a name from the
+ * next statement on, so register names up front to have every line see them.
+ */
+bool tree_sitter_xonsh_register_command(const char *name, size_t length);
+
+/**
+ * Forget every command name registered with
+ * tree_sitter_xonsh_register_command. Safe while other threads parse.
+ */
+void tree_sitter_xonsh_clear_commands(void);
+
+/**
+ * Number of distinct command names currently registered.
+ */
+size_t tree_sitter_xonsh_registered_command_count(void);
+
+/**
+ * Set how many characters bare subprocess detection may inspect per
+ * statement before it decides from what it has seen. Zero, the default (set
+ * at build time with TREE_SITTER_XONSH_DETECT_BUDGET), means no cap. With a
+ * cap, a long line whose shell signals come before it and whose `=` or `==`
+ * comes after it parses as a subprocess rather than as Python.
+ * Returns the previous budget. Process-wide, and safe to change while other
+ * threads parse, which pick up the new budget as they go.
+ */
+uint32_t tree_sitter_xonsh_set_detect_lookahead_budget(uint32_t budget);
+
+/**
+ * What a line of xonsh starts, as decided by bare subprocess detection.
+ */
+typedef enum {
+    TREE_SITTER_XONSH_LINE_PYTHON,            // Python statement, blank or comment line
+    TREE_SITTER_XONSH_LINE_SUBPROCESS,        // Bare subprocess: ls -la, cd /tmp
+    TREE_SITTER_XONSH_LINE_SUBPROCESS_MACRO,  // Subprocess macro: echo! text
+    TREE_SITTER_XONSH_LINE_BLOCK_MACRO,       // Block macro: with! Context():
+} TreeSitterXonshLineKind;
+
+/**
+ * Classify the statement at the start of `line` (`length` bytes of UTF-8,
+ * not necessarily NUL-terminated) the way the scanner does at a statement
+ * start, without building a tree. Leading spaces and tabs are skipped;
+ * detection stops at the end of the first line.
+ *
+ * For macros, `macro_end` (if not NULL) receives the byte offset just past
+ * "identifier! " or "with!", i.e. where the macro's argument text starts;
+ * otherwise it is set to 0.
+ *
+ * Safe to call from any thread, concurrently with parsing, with other calls
+ * and with changes to the command registry or the lookahead budget.
+ */
+TreeSitterXonshLineKind tree_sitter_xonsh_classify_line(const char *line, size_t length, size_t *macro_end);
+
+/**
+ * Free the scanners parked in the calling thread's pool. Scanners are only
+ * pooled when the library is built with TREE_SITTER_XONSH_SCANNER_POOL, so
+ * this does nothing otherwise; with the pool, call it before a thread that
+ * deleted parsers exits.
+ */
+void tree_sitter_xonsh_scanner_pool_drain(void);
+
+/*
+ * Scanner counters, compiled in when the library is built with
+ * TREE_SITTER_XONSH_STATS (otherwise they all read as zero). Counters are
+ * process-wide: each thread counts into its own block, which reads sum, so
+ * concurrent parses lose no increments. A read while others parse sees each
+ * counter as of some moment during the read.
+ */
+
+/**
+ * Whether the library was built with TREE_SITTER_XONSH_STATS.
+ */
+bool tree_sitter_xonsh_stats_enabled(void);
+
+/**
+ * Zero every counter and forget the recorded valid_symbols combinations.
+ */
+void tree_sitter_xonsh_stats_reset(void);
+
+/**
+ * Copy up to `capacity` counters into `values` and return how many counters
+ * there are. Counter `i` is named by tree_sitter_xonsh_stats_counter_name(i):
+ * scanner calls, calls that produced no token, characters advanced over
+ * ("scan_advances", detection included), tokens emitted per external
+ * token type ("token.indent", ...), bare subprocess detection calls and the
+ * characters they inspected, detection results ("detect_result.subprocess",
+ * ...), and calls whose valid_symbols combination did not fit the table.
+ */
+size_t tree_sitter_xonsh_stats_read(uint64_t *values, size_t capacity);
+
+/**
+ * Name of counter `index`, or NULL past the last one.
+ */
+const char *tree_sitter_xonsh_stats_counter_name(size_t index);
+
+/**
+ * Copy up to `capacity` of the valid_symbols combinations the scanner was
+ * called with into `masks` (bit i set when external token i, in grammar.js
+ * `externals` order, was valid) and their call counts into `calls`, summed
+ * over threads. Returns the number of distinct combinations recorded, at
+ * most 128.
+ */
+size_t tree_sitter_xonsh_stats_read_valid_symbols(uint32_t *masks, uint64_t *calls, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TREE_SITTER_XONSH_API_H_
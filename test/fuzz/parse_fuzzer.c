@@ -0,0 +1,79 @@
+/**
+ * libFuzzer target: parse arbitrary input with the full xonsh language.
+ *
+ * Built by `make fuzz` with the scanner counters compiled in (see
+ * scanner_stats.h). Besides crashes and sanitizer reports, it aborts when the
+ * scanner works too hard for the input it was given: more characters advanced
+ * or more scan calls than a fixed multiple of the input length. Untrusted
+ * files that parse slowly are what we are after, and a scanner loop that
+ * rescans its input shows up here long before it hits libFuzzer's timeout.
+ *
+ *   make fuzz FUZZ_ARGS='-max_total_time=600'
+ */
+
+#include <tree_sitter/api.h>
+
+#include "tree-sitter-xonsh.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Budgets per input byte, plus a constant for very short inputs. Error
+// recovery calls the scanner at every position it retries, so the limits
+// leave room for that; rescanning the input grows past them.
+#ifndef FUZZ_ADVANCES_PER_BYTE
+#define FUZZ_ADVANCES_PER_BYTE 64
+#endif
+#ifndef FUZZ_SCAN_CALLS_PER_BYTE
+#define FUZZ_SCAN_CALLS_PER_BYTE 16
+#endif
+#define FUZZ_WORK_SLACK 4096
+
+static size_t counter_index(const char *name) {
+    for (size_t i = 0; tree_sitter_xonsh_stats_counter_name(i) != NULL; i++) {
+        if (strcmp(tree_sitter_xonsh_stats_counter_name(i), name) == 0) {
+            return i;
+        }
+    }
+    fprintf(stderr, "no scanner counter named %s\n", name);
+    abort();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static TSParser *parser;
+    static uint64_t *values;
+    static size_t advances, scan_calls, counter_count;
+    if (!parser) {
+        if (!tree_sitter_xonsh_stats_enabled()) {
+            fprintf(stderr, "build the fuzzer with -DTREE_SITTER_XONSH_STATS\n");
+            abort();
+        }
+        parser = ts_parser_new();
+        ts_parser_set_language(parser, tree_sitter_xonsh());
+        advances = counter_index("scan_advances");
+        scan_calls = counter_index("scan_calls");
+        counter_count = tree_sitter_xonsh_stats_read(NULL, 0);
+        values = calloc(counter_count, sizeof(uint64_t));
+    }
+    if (size > UINT32_MAX) {
+        return 0;
+    }
+
+    tree_sitter_xonsh_stats_reset();
+    TSTree *tree = ts_parser_parse_string(parser, NULL, (const char *)data, (uint32_t)size);
+    ts_tree_delete(tree);
+
+    tree_sitter_xonsh_stats_read(values, counter_count);
+    uint64_t advance_budget = FUZZ_ADVANCES_PER_BYTE * (uint64_t)size + FUZZ_WORK_SLACK;
+    uint64_t call_budget = FUZZ_SCAN_CALLS_PER_BYTE * (uint64_t)size + FUZZ_WORK_SLACK;
+    if (values[advances] > advance_budget || values[scan_calls] > call_budget) {
+        fprintf(stderr, "scanner work over budget for %zu bytes: %llu characters advanced (budget %llu), "
+                        "%llu scan calls (budget %llu)\n",
+                size, (unsigned long long)values[advances], (unsigned long long)advance_budget,
+                (unsigned long long)values[scan_calls], (unsigned long long)call_budget);
+        abort();
+    }
+    return 0;
+}
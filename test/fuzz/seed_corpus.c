@@ -0,0 +1,41 @@
+/**
+ * Write the test inputs of corpus files out as a libFuzzer seed corpus.
+ *
+ * Each input between a test header and its `---` separator becomes one file
+ * in the output directory, named after the corpus file and its position.
+ *
+ *   test/fuzz/seed_corpus <directory> test/corpus/<file>.txt ...
+ */
+
+#include "../../bench/corpus.h"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <directory> <corpus file> ...\n", argv[0]);
+        return 1;
+    }
+    for (int i = 2; i < argc; i++) {
+        SourceText text;
+        if (!source_text_read(argv[i], &text)) {
+            return 1;
+        }
+        const char *name = strrchr(argv[i], '/');
+        name = name ? name + 1 : argv[i];
+        size_t name_length = strcspn(name, ".");
+
+        size_t cursor = 0, start, end;
+        for (unsigned index = 0; corpus_next_input(&text, &cursor, &start, &end); index++) {
+            char path[4096];
+            snprintf(path, sizeof(path), "%s/%.*s-%03u.xsh", argv[1], (int)name_length, name, index);
+            FILE *file = fopen(path, "wb");
+            if (!file) {
+                perror(path);
+                return 1;
+            }
+            fwrite(&text.data[start], 1, end - start, file);
+            fclose(file);
+        }
+        source_text_free(&text);
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * Parse time of adversarial inputs grows linearly with their size.
+ *
+ * Links libtree-sitter-xonsh.a and the tree-sitter runtime, and parses each
+ * adversarial input (see bench/generate.h) at 1x, 10x and 100x a base size.
+ * Fails if the best time per byte at one size is more than twice that at the
+ * size before it: linear parsing keeps it flat, while a quadratic step shows
+ * up as ten times. test/scanner/scaling checks the scanner's share exactly;
+ * this catches the rest of the parse. Run by `make test`.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <tree_sitter/api.h>
+
+#include "tree-sitter-xonsh.h"
+
+#include "../../bench/generate.h"
+
+#include <stdint.h>
+#include <time.h>
+
+#define BASE_SIZE 16384
+#define MIN_RUNS 3
+#define MIN_NANOSECONDS 50000000u
+
+static int failures;
+
+#define check(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Best parse time of `source`, in nanoseconds per byte.
+ */
+static double best_ns_per_byte(TSParser *parser, const TextBuffer *source) {
+    uint64_t best = UINT64_MAX, elapsed = 0;
+    for (unsigned runs = 0; runs < MIN_RUNS || elapsed < MIN_NANOSECONDS; runs++) {
+        uint64_t start = now_ns();
+        TSTree *tree = ts_parser_parse_string(parser, NULL, source->data, (uint32_t)source->length);
+        uint64_t run_ns = now_ns() - start;
+        ts_tree_delete(tree);
+        elapsed += run_ns;
+        if (run_ns < best) {
+            best = run_ns;
+        }
+    }
+    return (double)best / (double)source->length;
+}
+
+int main(void) {
+    TSParser *parser = ts_parser_new();
+    if (!ts_parser_set_language(parser, tree_sitter_xonsh())) {
+        fprintf(stderr, "incompatible tree-sitter-xonsh language version\n");
+        return 1;
+    }
+
+    for (int kind = 0; kind < ADVERSARIAL_KIND_COUNT; kind++) {
+        const char *name = adversarial_input_names[kind];
+        size_t previous_size = 0;
+        double previous_ns = 0;
+        for (size_t size = BASE_SIZE; size <= 100 * BASE_SIZE; size *= 10) {
+            TextBuffer source = {0};
+            generate_adversarial(&source, (AdversarialInput)kind, size);
+            double ns = best_ns_per_byte(parser, &source);
+            check(previous_size == 0 || ns <= 2 * previous_ns,
+                  "%s: %.2f ns/byte at %zu bytes, %.2f ns/byte at %zu bytes", name, ns, source.length, previous_ns,
+                  previous_size);
+            previous_size = source.length;
+            previous_ns = ns;
+            text_buffer_free(&source);
+        }
+    }
+
+    ts_parser_delete(parser);
+    if (failures == 0) {
+        printf("parse scaling: ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
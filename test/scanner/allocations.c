@@ -0,0 +1,184 @@
+/**
+ * Heap allocations made by the external scanner.
+ *
+ * Overrides the ts_* allocation macros with counting wrappers before pulling
+ * in the scanner, then replays what tree-sitter does while parsing: restore a
+ * state, scan a token, save the state. Shallow states must never touch the
+ * heap, and deep ones only until the stacks have grown to fit them. Built a
+ * second time with TREE_SITTER_XONSH_SCANNER_POOL to check that pooled
+ * scanners are reused and drained.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Calls that hit the allocator, and blocks currently allocated
+static size_t allocations;
+static size_t live_blocks;
+
+static void *counting_malloc(size_t size) {
+    allocations++;
+    live_blocks++;
+    return malloc(size);
+}
+
+static void *counting_calloc(size_t count, size_t size) {
+    allocations++;
+    live_blocks++;
+    return calloc(count, size);
+}
+
+static void *counting_realloc(void *ptr, size_t size) {
+    allocations++;
+    live_blocks += ptr == NULL;
+    return realloc(ptr, size);
+}
+
+static void counting_free(void *ptr) {
+    live_blocks -= ptr != NULL;
+    free(ptr);
+}
+
+#define ts_malloc counting_malloc
+#define ts_calloc counting_calloc
+#define ts_realloc counting_realloc
+#define ts_free counting_free
+
+#include "../../src/scanner.c"
+
+#include "../../src/buffer_lexer.h"
+
+static int failures;
+
+#define check(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+/**
+ * Scan one token at the start of `source` with only `symbols` valid.
+ */
+static bool scan(Scanner *scanner, const char *source, const enum TokenType *symbols, size_t symbol_count) {
+    bool valid_symbols[PATH_PREFIX + 1] = {false};
+    for (size_t i = 0; i < symbol_count; i++) {
+        valid_symbols[symbols[i]] = true;
+    }
+    BufferLexer lexer = {0};
+    buffer_lexer_reset(&lexer, source, strlen(source), 0);
+    return tree_sitter_xonsh_external_scanner_scan(scanner, &lexer.lexer, valid_symbols);
+}
+
+/**
+ * A state `depth` blocks deep (4 columns each) inside `strings` nested
+ * f-strings.
+ */
+static unsigned make_state(Scanner *scratch, uint32_t depth, uint32_t strings, char *buffer) {
+    tree_sitter_xonsh_external_scanner_deserialize(scratch, NULL, 0);
+    for (uint32_t i = 1; i <= depth; i++) {
+        inline_array_push(&scratch->indents, (uint16_t)(4 * i));
+    }
+    for (uint32_t i = 0; i < strings; i++) {
+        Delimiter delimiter = new_delimiter();
+        set_end_character(&delimiter, i % 2 ? '\'' : '"');
+        set_format(&delimiter);
+        inline_array_push(&scratch->delimiters, delimiter);
+    }
+    scratch->inside_f_string = strings > 0;
+    return tree_sitter_xonsh_external_scanner_serialize(scratch, buffer);
+}
+
+/**
+ * Restore each state, scan an indent, a dedent and a string start on top of
+ * it, and save the result, `rounds` times over. Returns the allocations made.
+ */
+static size_t replay(Scanner *scanner, char states[][TREE_SITTER_SERIALIZATION_BUFFER_SIZE],
+                     const unsigned *lengths, size_t state_count, int rounds) {
+    static const enum TokenType layout[] = {NEWLINE, INDENT, DEDENT};
+    static const enum TokenType string_start[] = {STRING_START};
+    char buffer[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+
+    size_t before = allocations;
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < state_count; i++) {
+            tree_sitter_xonsh_external_scanner_deserialize(scanner, states[i], lengths[i]);
+            scan(scanner, "\n                                                                    x\n", layout, 3);
+            tree_sitter_xonsh_external_scanner_serialize(scanner, buffer);
+
+            tree_sitter_xonsh_external_scanner_deserialize(scanner, states[i], lengths[i]);
+            scan(scanner, "\nx\n", layout, 3);
+            tree_sitter_xonsh_external_scanner_serialize(scanner, buffer);
+
+            tree_sitter_xonsh_external_scanner_deserialize(scanner, states[i], lengths[i]);
+            scan(scanner, "f'{x}'\n", string_start, 1);
+            tree_sitter_xonsh_external_scanner_serialize(scanner, buffer);
+        }
+    }
+    return allocations - before;
+}
+
+int main(void) {
+    static char states[4][TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+    unsigned lengths[4];
+
+    Scanner *scratch = tree_sitter_xonsh_external_scanner_create();
+    Scanner *scanner = tree_sitter_xonsh_external_scanner_create();
+    check(allocations == 2 && live_blocks == 2, "creating two scanners made %zu allocations", allocations);
+
+    // The scans themselves behave as expected
+    static const enum TokenType layout[] = {NEWLINE, INDENT, DEDENT};
+    check(scan(scanner, "\n    x\n", layout, 3) && scanner->indents.size == 2, "no indent scanned");
+    check(scan(scanner, "\nx\n", layout, 3) && scanner->indents.size == 1, "no dedent scanned");
+
+    // Shallow states stay in the inline storage
+    lengths[0] = make_state(scratch, 0, 0, states[0]);
+    lengths[1] = make_state(scratch, 3, 0, states[1]);
+    lengths[2] = make_state(scratch, SCANNER_INLINE_CAPACITY - 2, 2, states[2]);
+    lengths[3] = make_state(scratch, 6, SCANNER_INLINE_CAPACITY - 1, states[3]);
+    size_t shallow = replay(scanner, states, lengths, 4, 1000);
+    check(shallow == 0, "shallow states allocated %zu times", shallow);
+
+    // Deep states allocate once, then reuse the grown capacity
+    lengths[0] = make_state(scratch, 40, 0, states[0]);
+    lengths[1] = make_state(scratch, 2, 40, states[1]);
+    lengths[2] = make_state(scratch, 60, 30, states[2]);
+    size_t warmup = replay(scanner, states, lengths, 3, 1);
+    check(warmup > 0, "deep states never left the inline storage");
+    size_t deep = replay(scanner, states, lengths, 3, 1000);
+    check(deep == 0, "deep states allocated %zu times after warmup", deep);
+
+    // Restored states round-trip exactly
+    char buffer[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+    tree_sitter_xonsh_external_scanner_deserialize(scanner, states[2], lengths[2]);
+    unsigned length = tree_sitter_xonsh_external_scanner_serialize(scanner, buffer);
+    check(length == lengths[2] && memcmp(buffer, states[2], length) == 0, "state changed across a round trip");
+    check(scanner->indents.size == 61 && scanner->delimiters.size == 30, "restored %u indents, %u delimiters",
+          scanner->indents.size, scanner->delimiters.size);
+
+    tree_sitter_xonsh_external_scanner_destroy(scanner);
+    tree_sitter_xonsh_external_scanner_destroy(scratch);
+
+#ifdef TREE_SITTER_XONSH_SCANNER_POOL
+    // Pooled scanners come back empty, without new allocations
+    check(live_blocks == 2, "pool kept %zu blocks instead of the two scanners", live_blocks);
+    size_t before = allocations;
+    for (int i = 0; i < 1000; i++) {
+        Scanner *pooled = tree_sitter_xonsh_external_scanner_create();
+        check(pooled->indents.size == 1 && pooled->delimiters.size == 0 && !pooled->inside_f_string,
+              "pooled scanner kept its old state");
+        tree_sitter_xonsh_external_scanner_destroy(pooled);
+    }
+    check(allocations == before, "pooled create/destroy allocated %zu times", allocations - before);
+    tree_sitter_xonsh_scanner_pool_drain();
+#endif
+    check(live_blocks == 0, "leaked %zu blocks", live_blocks);
+
+    if (failures == 0) {
+        printf("allocations: ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+/**
+ * tree_sitter_xonsh_classify_line, the parse-free line classifier.
+ *
+ * Checks that it agrees with what the scanner decides at a statement start,
+ * reports macro argument offsets, and stops at the buffer length rather than
+ * at a NUL.
+ */
+
+#include "../../src/scanner.c"
+
+#include <stdio.h>
+
+static int failures;
+
+#define check(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+typedef struct {
+    const char *line;
+    TreeSitterXonshLineKind kind;
+    size_t macro_end;
+} Classification;
+
+static const Classification classifications[] = {
+    {"ls -la /tmp", TREE_SITTER_XONSH_LINE_SUBPROCESS, 0},
+    {"    cat file | wc -l\n", TREE_SITTER_XONSH_LINE_SUBPROCESS, 0},
+    {"./configure --prefix=/usr", TREE_SITTER_XONSH_LINE_SUBPROCESS, 0},
+    {"echo hello", TREE_SITTER_XONSH_LINE_SUBPROCESS, 0},
+    {"x = 1", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"history = []", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"print(x)", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"if ready:", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"f\"{name}\"", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"'quoted'", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"# ls -la", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"   \n", TREE_SITTER_XONSH_LINE_PYTHON, 0},
+    {"echo! Hello world", TREE_SITTER_XONSH_LINE_SUBPROCESS_MACRO, 6},
+    {"  echo!   Hello", TREE_SITTER_XONSH_LINE_SUBPROCESS_MACRO, 10},
+    {"with! Context():", TREE_SITTER_XONSH_LINE_BLOCK_MACRO, 5},
+};
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(classifications) / sizeof(classifications[0]); i++) {
+        const Classification *expected = &classifications[i];
+        size_t macro_end = 99;
+        TreeSitterXonshLineKind kind =
+            tree_sitter_xonsh_classify_line(expected->line, strlen(expected->line), &macro_end);
+        check(kind == expected->kind, "'%s' classified as %d, expected %d", expected->line, kind, expected->kind);
+        check(macro_end == expected->macro_end, "'%s' macro_end %zu, expected %zu", expected->line, macro_end,
+              expected->macro_end);
+    }
+
+    // Only `length` bytes are looked at: the flag past it must not count
+    static const char prefix[] = "value -v";
+    check(tree_sitter_xonsh_classify_line(prefix, 5, NULL) == TREE_SITTER_XONSH_LINE_PYTHON,
+          "read past the given length");
+    check(tree_sitter_xonsh_classify_line(prefix, sizeof(prefix) - 1, NULL) == TREE_SITTER_XONSH_LINE_SUBPROCESS,
+          "flag not seen");
+
+    // Registered commands count, like they do for the scanner
+    check(tree_sitter_xonsh_classify_line("myregisteredapp", 15, NULL) == TREE_SITTER_XONSH_LINE_PYTHON,
+          "unregistered command started a subprocess");
+    tree_sitter_xonsh_register_command("myregisteredapp", 15);
+    check(tree_sitter_xonsh_classify_line("myregisteredapp", 15, NULL) == TREE_SITTER_XONSH_LINE_SUBPROCESS,
+          "registered command did not start a subprocess");
+    tree_sitter_xonsh_clear_commands();
+
+    if (failures == 0) {
+        printf("classify_line: ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/**
+ * Command names registered and cleared while other threads look them up.
+ *
+ * One thread registers batches of names, growing the table through several
+ * rehashes, and clears them again, over and over; the others classify lines
+ * starting with those names meanwhile. Lookups must never see a freed table
+ * (build with -fsanitize=thread or address to catch that reliably), names
+ * never registered must never match, and the last batch must stay found once
+ * the writer is done.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../../src/scanner.c"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#define READERS 4
+#define ROUNDS 50
+#define NAMES 2000
+
+static int failures;
+
+#define check(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+static volatile uint32_t writer_done;
+
+static size_t name_at(char *name, size_t size, const char *prefix, unsigned index) {
+    return (size_t)snprintf(name, size, "%s%u", prefix, index);
+}
+
+static void *writer(void *unused) {
+    (void)unused;
+    char name[32];
+    for (unsigned round = 0; round < ROUNDS; round++) {
+        tree_sitter_xonsh_clear_commands();
+        for (unsigned i = 0; i < NAMES; i++) {
+            tree_sitter_xonsh_register_command(name, name_at(name, sizeof name, "regcmd", i));
+        }
+    }
+    relaxed_store_u32(&writer_done, 1);
+    return NULL;
+}
+
+static void *reader(void *result) {
+    char name[32];
+    unsigned i = 0;
+    unsigned *false_matches = result;
+    while (!relaxed_load_u32(&writer_done)) {
+        size_t length = name_at(name, sizeof name, "regcmd", i % NAMES);
+        tree_sitter_xonsh_classify_line(name, length, NULL);
+        length = name_at(name, sizeof name, "unregcmd", i % NAMES);
+        if (tree_sitter_xonsh_classify_line(name, length, NULL) != TREE_SITTER_XONSH_LINE_PYTHON) {
+            (*false_matches)++;
+        }
+        i++;
+    }
+    return NULL;
+}
+
+int main(void) {
+    pthread_t writer_thread, reader_threads[READERS];
+    unsigned false_matches[READERS] = {0};
+
+    for (int i = 0; i < READERS; i++) {
+        pthread_create(&reader_threads[i], NULL, reader, &false_matches[i]);
+    }
+    pthread_create(&writer_thread, NULL, writer, NULL);
+    pthread_join(writer_thread, NULL);
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(reader_threads[i], NULL);
+        check(false_matches[i] == 0, "reader %d matched %u unregistered names", i, false_matches[i]);
+    }
+
+    check(tree_sitter_xonsh_registered_command_count() == NAMES, "%zu names registered, expected %d",
+          tree_sitter_xonsh_registered_command_count(), NAMES);
+    char name[32];
+    for (unsigned i = 0; i < NAMES; i++) {
+        size_t length = name_at(name, sizeof name, "regcmd", i);
+        check(tree_sitter_xonsh_classify_line(name, length, NULL) == TREE_SITTER_XONSH_LINE_SUBPROCESS,
+              "%s not found after the last round", name);
+    }
+    tree_sitter_xonsh_clear_commands();
+
+    if (failures == 0) {
+        printf("command_registry: ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+/**
+ * Lookahead recorded by bare subprocess detection.
+ *
+ * Tree-sitter invalidates a token when an edit lands anywhere it looked at,
+ * so detection should stop at the first character that decides the line.
+ * Checks that lines settled by a strong Python signal look no further than
+ * that signal, however long the rest of the line is. Shell signals do not
+ * settle a line: a later `=`, `==`, `!=` or `:=` still makes it Python, so
+ * those lines need the whole statement.
+ */
+
+#include "../../src/scanner.c"
+
+#include "../../src/buffer_lexer.h"
+
+#include <stdio.h>
+
+static int failures;
+
+#define check(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+typedef struct {
+    DetectResult result;
+    size_t inspected;
+} Detection;
+
+static Detection detect(const char *source) {
+    BufferLexer lexer = {0};
+    buffer_lexer_reset(&lexer, source, strlen(source), 0);
+    size_t macro_end = 0;
+    Delimiter delimiter = new_delimiter();
+    Detection detection;
+    detection.result = detect_subprocess_line(&lexer.lexer, &macro_end, &delimiter);
+    detection.inspected = (size_t)lexer.advances;
+    return detection;
+}
+
+typedef struct {
+    const char *prefix;  // Up to and including the deciding signal
+    DetectResult result;
+} SettledLine;
+
+static const SettledLine settled_lines[] = {
+    {"x = ", DETECT_NONE},
+    {"x == ", DETECT_NONE},
+    {"x != ", DETECT_NONE},
+    {"x <= ", DETECT_NONE},
+    {"x >= ", DETECT_NONE},
+    {"(n := ", DETECT_NONE},
+    {"items.append(", DETECT_NONE},
+    {"config.", DETECT_NONE},
+    {"macro!(", DETECT_NONE},
+    {"items[", DETECT_NONE},
+};
+
+typedef struct {
+    const char *line;
+    DetectResult result;
+} OpenLine;
+
+// Lines whose shell signals a later Python operator overrides, or does not
+static const OpenLine open_lines[] = {
+    {"ls -la\n", DETECT_SUBPROCESS},
+    {"cat file | grep x\n", DETECT_SUBPROCESS},
+    {"make all && make install\n", DETECT_SUBPROCESS},
+    {"sort data > out\n", DETECT_SUBPROCESS},
+    {"run args $HOME\n", DETECT_SUBPROCESS},
+    {"mycmd --key=value\n", DETECT_SUBPROCESS},
+    {"echo @(x == 1)\n", DETECT_SUBPROCESS},
+    {"docker run -e FOO=bar\n", DETECT_NONE},
+    {"cat f | grep x=1\n", DETECT_NONE},
+    {"x -y == z\n", DETECT_NONE},
+    {"ls -la != y\n", DETECT_NONE},
+};
+
+int main(void) {
+    static const char tail[] = " lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod";
+
+    for (size_t i = 0; i < sizeof(settled_lines) / sizeof(settled_lines[0]); i++) {
+        const SettledLine *line = &settled_lines[i];
+        char short_line[256], long_line[1024];
+        snprintf(short_line, sizeof(short_line), "%sx\n", line->prefix);
+        snprintf(long_line, sizeof(long_line), "%sx%s%s%s\n", line->prefix, tail, tail, tail);
+
+        Detection short_detection = detect(short_line);
+        Detection long_detection = detect(long_line);
+        check(short_detection.result == line->result && long_detection.result == line->result,
+              "'%s...' detected as %d/%d, expected %d", line->prefix, short_detection.result,
+              long_detection.result, line->result);
+        check(long_detection.inspected <= strlen(line->prefix) + 1,
+              "'%s...' inspected %zu characters", line->prefix, long_detection.inspected);
+    }
+
+    for (size_t i = 0; i < sizeof(open_lines) / sizeof(open_lines[0]); i++) {
+        const OpenLine *line = &open_lines[i];
+        Detection detection = detect(line->line);
+        check(detection.result == line->result, "'%s' detected as %d, expected %d", line->line,
+              detection.result, line->result);
+        check(line->result == DETECT_NONE || detection.inspected >= strlen(line->line) - 1,
+              "'%s' settled after %zu characters", line->line, detection.inspected);
+    }
+
+    // Known commands and bare words stay open: a later `=` still makes the line Python
+    check(detect("history = []\n").result == DETECT_NONE, "assignment to a known command name");
+    check(detect("echo hello world\n").result == DETECT_SUBPROCESS, "known command with bare words");
+    Detection bare = detect("echo hello world\n");
+    check(bare.inspected >= strlen("echo hello world"), "bare words settled after %zu characters",
+          bare.inspected);
+
+    // Uncapped by default, so a late `==` still makes a long shell-looking line
+    // Python; a caller that sets a budget gets a decision from what fits in it
+    char long_shell[4096] = "ls -la";
+    while (strlen(long_shell) < 2048) {
+        strcat(long_shell, " word");
+    }
+    strcat(long_shell, " == y\n");
+    check(detect(long_shell).result == DETECT_NONE, "late == on a long line detected as %d",
+          detect(long_shell).result);
+    uint32_t previous = tree_sitter_xonsh_set_detect_lookahead_budget(1024);
+    check(previous == 0, "default budget %u, expected no cap", previous);
+    Detection capped = detect(long_shell);
+    check(capped.result == DETECT_SUBPROCESS && capped.inspected <= 1024 + 8,
+          "with a 1024 budget: detected as %d after %zu characters", capped.result, capped.inspected);
+    tree_sitter_xonsh_set_detect_lookahead_budget(previous);
+
+    if (failures == 0) {
+        printf("lookahead: ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
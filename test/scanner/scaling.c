@@ -0,0 +1,161 @@
+/**
+ * Scanner work on adversarial inputs grows linearly with their size.
+ *
+ * Generates each adversarial input (see bench/generate.h) at 1x, 10x and
+ * 100x a base size and walks the scanner over it the way the parser calls
+ * it: statement starts at every line, the statement end at every code line's
+ * newline, and string bodies token by token. Comment lines are left to the
+ * grammar, which calls back in at each of their newlines. Counts characters
+ * the scanner reads rather than time, so the check is exact and fast, and
+ * fails if the count per byte grows by more than half from one size to the
+ * next.
+ */
+
+#include "../../src/scanner.c"
+
+#include "../../src/buffer_lexer.h"
+#include "../../bench/generate.h"
+
+#include <stdio.h>
+
+#define BASE_SIZE 4096
+#define WORK_SLACK 1024
+
+static int failures;
+
+#define check(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+typedef struct {
+    Scanner *scanner;
+    BufferLexer lexer;
+    const char *data;
+    size_t length;
+    bool statement_start[PATH_PREFIX + 1];
+    bool statement_end[PATH_PREFIX + 1];
+    bool block_start[PATH_PREFIX + 1];
+    bool string_body[PATH_PREFIX + 1];
+} Walk;
+
+/**
+ * Call the scanner at `position`. Returns the end of the token it produced,
+ * or `position` if it produced none.
+ */
+static size_t walk_scan(Walk *self, size_t position, const bool *valid_symbols) {
+    buffer_lexer_reset(&self->lexer, self->data, self->length, position);
+    if (tree_sitter_xonsh_external_scanner_scan(self->scanner, &self->lexer.lexer, valid_symbols)) {
+        return self->lexer.marked_end;
+    }
+    return position;
+}
+
+/**
+ * Scan a string body from `position` to its end quotes, stepping over what
+ * the grammar lexes itself. An unclosed single-line string ends at its
+ * newline, where the parser would recover. Returns where the string ended.
+ */
+static size_t walk_string(Walk *self, size_t position) {
+    while (position < self->length) {
+        size_t end = walk_scan(self, position, self->string_body);
+        if (end > position) {
+            position = end;
+            if (self->lexer.lexer.result_symbol == STRING_END) {
+                return position;
+            }
+            continue;
+        }
+        char c = self->data[position];
+        if (c == '\n' && !is_triple(array_back(&self->scanner->delimiters))) {
+            break;
+        }
+        if (c == '{') {
+            const char *close = memchr(&self->data[position], '}', self->length - position);
+            position = close ? (size_t)(close - self->data) + 1 : self->length;
+        } else {
+            position += c == '\\' ? 2 : 1;
+        }
+    }
+    array_clear(&self->scanner->delimiters);
+    return position;
+}
+
+/**
+ * Walk the whole input and return how many characters the scanner read.
+ */
+static uint64_t walk(const char *data, size_t length) {
+    Walk self = {0};
+    self.scanner = tree_sitter_xonsh_external_scanner_create();
+    self.data = data;
+    self.length = length;
+    self.lexer.advances = 0;
+    bool *start = self.statement_start;
+    start[DEDENT] = start[SUBPROCESS_START] = start[SUBPROCESS_MACRO_START] = start[BLOCK_MACRO_START] =
+        start[STRING_START] = start[PATH_PREFIX] = true;
+    self.statement_end[NEWLINE] = self.statement_end[DEDENT] = true;
+    self.block_start[NEWLINE] = self.block_start[INDENT] = true;
+    self.string_body[STRING_CONTENT] = self.string_body[STRING_END] = self.string_body[ESCAPE_INTERPOLATION] = true;
+
+    size_t position = 0;
+    while (position < length) {
+        const char *newline = memchr(&data[position], '\n', length - position);
+        size_t line_end = newline ? (size_t)(newline - data) : length;
+        size_t first = position;
+        while (first < line_end && (data[first] == ' ' || data[first] == '\t')) {
+            first++;
+        }
+
+        size_t end = walk_scan(&self, position, self.statement_start);
+        if (end > position && self.lexer.lexer.result_symbol == STRING_START) {
+            end = walk_string(&self, end);
+            if (end > line_end) {
+                newline = memchr(&data[end], '\n', length - end);
+                line_end = newline ? (size_t)(newline - data) : length;
+            }
+        }
+        if (first < line_end && data[first] == '#') {
+            walk_scan(&self, line_end, self.statement_start);
+        } else if (first < line_end) {
+            walk_scan(&self, line_end, data[line_end - 1] == ':' ? self.block_start : self.statement_end);
+        }
+        position = line_end + 1;
+    }
+
+    tree_sitter_xonsh_external_scanner_destroy(self.scanner);
+    return self.lexer.advances;
+}
+
+int main(void) {
+    for (int kind = 0; kind < ADVERSARIAL_KIND_COUNT; kind++) {
+        const char *name = adversarial_input_names[kind];
+        size_t previous_size = 0;
+        uint64_t previous_work = 0;
+        for (size_t size = BASE_SIZE; size <= 100 * BASE_SIZE; size *= 10) {
+            TextBuffer source = {0};
+            generate_adversarial(&source, (AdversarialInput)kind, size);
+            uint64_t work = walk(source.data, source.length);
+            if (previous_size) {
+                // Linear up to a half, plus some slack for inputs where the
+                // scanner barely reads anything
+                double allowed = 1.5 * (double)previous_work * (double)source.length / (double)previous_size +
+                                 WORK_SLACK;
+                check((double)work <= allowed, "%s: %llu characters read for %zu bytes, %llu for %zu bytes", name,
+                      (unsigned long long)work, source.length, (unsigned long long)previous_work, previous_size);
+            }
+            previous_size = source.length;
+            previous_work = work;
+            text_buffer_free(&source);
+        }
+    }
+
+    if (failures == 0) {
+        printf("scaling: ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
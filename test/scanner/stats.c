@@ -0,0 +1,133 @@
+/**
+ * Scanner instrumentation counters.
+ *
+ * Builds the scanner with TREE_SITTER_XONSH_STATS, scans a few tokens and
+ * checks what the tree_sitter_xonsh_stats_* functions report, then scans on
+ * several threads at once and checks that no count is lost.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define TREE_SITTER_XONSH_STATS
+
+#include "../../src/scanner.c"
+
+#include "../../src/buffer_lexer.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#define THREADS 4
+#define THREAD_SCANS 20000
+
+static int failures;
+
+#define check(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+static bool scan_source(void *scanner, const char *source, const bool *valid_symbols) {
+    BufferLexer lexer = {0};
+    buffer_lexer_reset(&lexer, source, strlen(source), 0);
+    return tree_sitter_xonsh_external_scanner_scan(scanner, &lexer.lexer, valid_symbols);
+}
+
+static uint64_t counter(const char *name) {
+    uint64_t values[STAT_COUNT];
+    size_t count = tree_sitter_xonsh_stats_read(values, STAT_COUNT);
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tree_sitter_xonsh_stats_counter_name(i), name) == 0) {
+            return values[i];
+        }
+    }
+    fprintf(stderr, "no counter named %s\n", name);
+    failures++;
+    return 0;
+}
+
+static void *scan_on_thread(void *unused) {
+    (void)unused;
+    void *scanner = tree_sitter_xonsh_external_scanner_create();
+    bool statement[PATH_PREFIX + 1] = {false};
+    statement[SUBPROCESS_START] = true;
+    for (int i = 0; i < THREAD_SCANS; i++) {
+        scan_source(scanner, "ls -la\n", statement);
+    }
+    tree_sitter_xonsh_external_scanner_destroy(scanner);
+    return NULL;
+}
+
+int main(void) {
+    check(tree_sitter_xonsh_stats_enabled(), "stats not compiled in");
+
+    size_t count = tree_sitter_xonsh_stats_read(NULL, 0);
+    check(count == STAT_COUNT, "%zu counters reported", count);
+    for (size_t i = 0; i < count; i++) {
+        check(tree_sitter_xonsh_stats_counter_name(i) != NULL, "counter %zu has no name", i);
+    }
+    check(tree_sitter_xonsh_stats_counter_name(count) == NULL, "name past the last counter");
+
+    void *scanner = tree_sitter_xonsh_external_scanner_create();
+    bool layout[PATH_PREFIX + 1] = {false};
+    layout[NEWLINE] = layout[INDENT] = layout[DEDENT] = true;
+    bool statement[PATH_PREFIX + 1] = {false};
+    statement[SUBPROCESS_START] = statement[STRING_START] = true;
+
+    tree_sitter_xonsh_stats_reset();
+    check(scan_source(scanner, "\n    x\n", layout), "no indent");
+    check(scan_source(scanner, "\nx\n", layout), "no dedent");
+    check(scan_source(scanner, "ls -la /tmp\n", statement), "no subprocess start");
+    check(!scan_source(scanner, "x = 1\n", statement), "python line started a subprocess");
+
+    check(counter("scan_calls") == 4, "scan_calls = %llu", (unsigned long long)counter("scan_calls"));
+    check(counter("scan_no_token") == 1, "scan_no_token = %llu", (unsigned long long)counter("scan_no_token"));
+    check(counter("token.indent") == 1 && counter("token.dedent") == 1, "indent/dedent not counted");
+    check(counter("token.subprocess_start") == 1, "subprocess start not counted");
+    check(counter("detect_calls") == 2, "detect_calls = %llu", (unsigned long long)counter("detect_calls"));
+    check(counter("detect_result.subprocess") == 1 && counter("detect_result.none") == 1,
+          "detection results not counted");
+    check(counter("detect_advances") > 0, "no detection advances counted");
+    check(counter("scan_advances") > counter("detect_advances"), "scan_advances = %llu",
+          (unsigned long long)counter("scan_advances"));
+
+    uint32_t masks[8];
+    uint64_t calls[8];
+    size_t combinations = tree_sitter_xonsh_stats_read_valid_symbols(masks, calls, 8);
+    check(combinations == 2, "%zu valid_symbols combinations", combinations);
+    for (size_t i = 0; i < combinations && i < 8; i++) {
+        uint32_t layout_mask = 1u << NEWLINE | 1u << INDENT | 1u << DEDENT;
+        uint32_t statement_mask = 1u << SUBPROCESS_START | 1u << STRING_START;
+        check((masks[i] == layout_mask || masks[i] == statement_mask) && calls[i] == 2,
+              "combination %#x called %llu times", masks[i], (unsigned long long)calls[i]);
+    }
+
+    tree_sitter_xonsh_stats_reset();
+    check(counter("scan_calls") == 0 && counter("detect_advances") == 0, "reset left counts behind");
+    check(tree_sitter_xonsh_stats_read_valid_symbols(masks, calls, 8) == 0, "reset left combinations behind");
+
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, scan_on_thread, NULL);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    check(counter("scan_calls") == THREADS * THREAD_SCANS, "scan_calls = %llu after %d threads",
+          (unsigned long long)counter("scan_calls"), THREADS);
+    check(counter("detect_result.subprocess") == THREADS * THREAD_SCANS, "detect_result.subprocess = %llu",
+          (unsigned long long)counter("detect_result.subprocess"));
+    size_t merged = tree_sitter_xonsh_stats_read_valid_symbols(masks, calls, 8);
+    check(merged == 1 && calls[0] == THREADS * THREAD_SCANS, "%zu combinations, first called %llu times",
+          merged, (unsigned long long)calls[0]);
+
+    tree_sitter_xonsh_external_scanner_destroy(scanner);
+    if (failures == 0) {
+        printf("stats: ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+/**
+ * Token boundaries inside string bodies.
+ *
+ * Scans string bodies after their opening quotes and checks where each
+ * STRING_CONTENT / STRING_END token ends. In particular, one or two quotes
+ * inside a triple-quoted string stay part of the surrounding content token
+ * instead of ending it.
+ */
+
+#include "../../src/scanner.c"
+
+#include <stdio.h>
+
+static int failures;
+
+#define check(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+typedef struct {
+    const char *body;  // String body after the opening quotes
+    uint8_t flags;
+    bool triple;
+    // Tokens the scanner produces from the start of the body, as
+    // "content:<end>" / "end:<end>", separated by spaces
+    const char *tokens;
+} StringCase;
+
+static const StringCase cases[] = {
+    {"plain\"\"\"", 0, true, "content:5 end:8"},
+    {"a \"quoted\" word\"\"\"", 0, true, "content:15 end:18"},
+    {"a \"\"doubled\"\" word\"\"\"", 0, true, "content:18 end:21"},
+    {"\"lead\"\"\"", 0, true, "content:5 end:8"},
+    {"a\"\"\"\"", 0, true, "content:1 end:4"},
+    {"open\"\"", 0, true, "content:6"},
+    {"a\"{b}c\"\"\"", Format, true, "content:2"},
+    {"line\\nnext\"\"\"", 0, true, "content:4"},
+    {"plain\"", 0, false, "content:5 end:6"},
+};
+
+static void describe(char *out, size_t size, const char *source, uint8_t flags, bool triple) {
+    Scanner *scanner = tree_sitter_xonsh_external_scanner_create();
+    Delimiter delimiter = {0};
+    delimiter.flags = flags;
+    set_end_character(&delimiter, '"');
+    if (triple) {
+        set_triple(&delimiter);
+    }
+    inline_array_push(&scanner->delimiters, delimiter);
+
+    bool valid_symbols[PATH_PREFIX + 1] = {false};
+    valid_symbols[STRING_CONTENT] = valid_symbols[STRING_END] = valid_symbols[ESCAPE_INTERPOLATION] = true;
+
+    size_t length = strlen(source), position = 0, written = 0;
+    out[0] = '\0';
+    while (position < length) {
+        BufferLexer lexer = {0};
+        buffer_lexer_reset(&lexer, source, length, position);
+        if (!tree_sitter_xonsh_external_scanner_scan(scanner, &lexer.lexer, valid_symbols) ||
+            lexer.marked_end <= position) {
+            break;
+        }
+        position = lexer.marked_end;
+        bool end = lexer.lexer.result_symbol == STRING_END;
+        written += (size_t)snprintf(&out[written], size - written, "%s%s:%zu", written ? " " : "",
+                                    end ? "end" : "content", position);
+        if (end || lexer.lexer.result_symbol != STRING_CONTENT) {
+            break;
+        }
+    }
+    tree_sitter_xonsh_external_scanner_destroy(scanner);
+}
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        char tokens[256];
+        describe(tokens, sizeof(tokens), cases[i].body, cases[i].flags, cases[i].triple);
+        check(strcmp(tokens, cases[i].tokens) == 0, "'%s' scanned as \"%s\", expected \"%s\"", cases[i].body,
+              tokens, cases[i].tokens);
+    }
+
+    if (failures == 0) {
+        printf("string_content: ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}